@@ -0,0 +1,309 @@
+/************************************************************************************
+ *   animation.cpp  --  This file is part of LIBYASVG.                              *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "animation.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <boost/format.hpp>
+
+/*****************************************************************
+ * FRAME PARAMETERS
+ *****************************************************************/
+
+/*
+ * @fn set_transform
+ *
+ * @brief apply an additional transformation to a shape
+ *
+ * @param idx       shape index
+ * @param matrix    transformation matrix
+ *
+ */
+void Svg2Cairo::FrameParameters::set_transform(size_t idx, const cairo_matrix_t& matrix) {
+    auto& sp = this->fetch(idx);
+    sp.has_transform = true;
+    sp.transform = matrix;
+}
+
+/*
+ * @fn set_color
+ *
+ * @brief replace the fill color of a shape
+ *
+ * @param idx       shape index
+ * @param _color    fill color
+ *
+ */
+void Svg2Cairo::FrameParameters::set_color(size_t idx, const Color& _color) {
+    auto& sp = this->fetch(idx);
+    sp.has_color = true;
+    sp.color = _color;
+}
+
+/*
+ * @fn clear
+ *
+ * @brief remove all overrides
+ *
+ */
+void Svg2Cairo::FrameParameters::clear() {
+    // keep the allocated storage, such that it can be reused for the next frame
+    std::fill(this->active.begin(), this->active.end(), false);
+}
+
+Svg2Cairo::ShapeParameters& Svg2Cairo::FrameParameters::fetch(size_t idx) {
+    if(idx >= this->shapes.size()) {
+        this->shapes.resize(idx + 1);
+        this->active.resize(idx + 1, false);
+    }
+
+    if(!this->active[idx]) {
+        this->shapes[idx] = ShapeParameters();
+        this->active[idx] = true;
+    }
+
+    return this->shapes[idx];
+}
+
+/*****************************************************************
+ * KEYFRAME TABLE
+ *****************************************************************/
+
+/*
+ * @fn add_keyframe
+ *
+ * @brief add a keyframe for a shape
+ *
+ * @param idx       shape index
+ * @param keyframe  keyframe
+ *
+ */
+void Svg2Cairo::KeyframeTable::add_keyframe(size_t idx, const Keyframe& keyframe) {
+    auto& track = this->tracks[idx];
+    auto it = std::upper_bound(track.begin(), track.end(), keyframe.frame,
+                               [](unsigned int frame, const Keyframe& kf) { return frame < kf.frame; });
+    track.insert(it, keyframe);
+}
+
+/*
+ * @fn apply
+ *
+ * @brief set the interpolated overrides of all animated shapes
+ *
+ * Frames before the first or after the last keyframe take the
+ * state of that keyframe.
+ *
+ * @param frame     frame number
+ * @param params    frame parameters to fill
+ *
+ */
+void Svg2Cairo::KeyframeTable::apply(unsigned int frame, FrameParameters& params) const {
+    for(const auto& track : this->tracks) {
+        const auto& kfs = track.second;
+        if(kfs.empty()) {
+            continue;
+        }
+
+        // find the pair of keyframes enclosing this frame
+        auto next = std::upper_bound(kfs.begin(), kfs.end(), frame,
+                                     [](unsigned int f, const Keyframe& kf) { return f < kf.frame; });
+        const Keyframe& k1 = (next == kfs.begin()) ? kfs.front() : *(next - 1);
+        const Keyframe& k2 = (next == kfs.end()) ? kfs.back() : *next;
+
+        double t = 0.0;
+        if(k2.frame > k1.frame) {
+            t = (double)(frame - k1.frame) / (double)(k2.frame - k1.frame);
+            t = std::min(1.0, std::max(0.0, t));
+        }
+
+        const double tx = k1.tx + t * (k2.tx - k1.tx);
+        const double ty = k1.ty + t * (k2.ty - k1.ty);
+        const double angle = k1.angle + t * (k2.angle - k1.angle);
+        const double scale = k1.scale + t * (k2.scale - k1.scale);
+
+        cairo_matrix_t matrix;
+        cairo_matrix_init_translate(&matrix, tx, ty);
+        cairo_matrix_rotate(&matrix, angle / 180.0 * M_PI);
+        cairo_matrix_scale(&matrix, scale, scale);
+        params.set_transform(track.first, matrix);
+
+        if(k1.has_color && k2.has_color) {
+            params.set_color(track.first, Color(std::lround(255.0 * (k1.color.get_r() + t * (k2.color.get_r() - k1.color.get_r()))),
+                                                std::lround(255.0 * (k1.color.get_g() + t * (k2.color.get_g() - k1.color.get_g()))),
+                                                std::lround(255.0 * (k1.color.get_b() + t * (k2.color.get_b() - k1.color.get_b()))),
+                                                std::lround(255.0 * (k1.color.get_a() + t * (k2.color.get_a() - k1.color.get_a())))));
+        } else if(k1.has_color || k2.has_color) {
+            params.set_color(track.first, k1.has_color ? k1.color : k2.color);
+        }
+    }
+}
+
+/*****************************************************************
+ * FRAME SEQUENCE
+ *****************************************************************/
+
+/*
+ * @fn FrameSequence
+ *
+ * @brief FrameSequence constructor
+ *
+ * @param _doc      document to render (must outlive the sequence)
+ * @param _width    width of a frame in pixels
+ * @param _height   height of a frame in pixels
+ *
+ */
+Svg2Cairo::FrameSequence::FrameSequence(const Svg2Cairo& _doc, unsigned int _width, unsigned int _height) :
+    doc(_doc), width(_width), height(_height), nr_threads(0), nr_surfaces(0) {}
+
+/*
+ * @fn render
+ *
+ * @brief render frames using a parameter callback
+ *
+ * The callback is executed on the calling thread in frame order and
+ * does therefore not have to be thread-safe.
+ *
+ * @param nr_frames number of frames
+ * @param callback  function filling the parameters of a frame
+ * @param encoder   function receiving the finished frames in order
+ *
+ */
+void Svg2Cairo::FrameSequence::render(unsigned int nr_frames, const FrameCallback& callback, const FrameEncoder& encoder) const {
+    WorkerPool pool(this->nr_threads);
+    const unsigned int nr_slots = this->nr_surfaces != 0 ? this->nr_surfaces : 2 * pool.get_nr_threads();
+
+    // a slot couples a surface to the parameters of the frame it is rendering
+    struct Slot {
+        cairo_surface_t* surface;
+        FrameParameters params;
+    };
+
+    std::vector<Slot> slots(nr_slots);
+    std::vector<Slot*> free_slots;
+    for(auto& slot : slots) {
+        slot.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, this->width, this->height);
+        free_slots.push_back(&slot);
+    }
+
+    // frames in flight, in frame order
+    std::deque<std::pair<Slot*, std::future<void> > > in_flight;
+    unsigned int next_encode = 0;
+
+    // hand the oldest frame to the encoder and recycle its surface
+    auto encode_next = [&]() {
+        auto item = std::move(in_flight.front());
+        in_flight.pop_front();
+        item.second.get();      // rethrows exceptions from the worker
+        Slot* slot = item.first;
+        encoder(next_encode++, slot->surface);
+        free_slots.push_back(slot);
+    };
+
+    try {
+        for(unsigned int frame=0; frame<nr_frames; frame++) {
+            // back-pressure: wait until the oldest frame is finished when all surfaces are in use
+            if(free_slots.empty()) {
+                encode_next();
+            }
+
+            Slot* slot = free_slots.back();
+            free_slots.pop_back();
+
+            slot->params.clear();
+            callback(frame, slot->params);
+
+            const Svg2Cairo& document = this->doc;
+            const RenderOptions& render_options = this->options;
+            in_flight.emplace_back(slot, pool.submit([slot, &document, &render_options]() {
+                auto cr = cairo_create(slot->surface);
+
+                // clear the surface from the previous frame
+                cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+                cairo_paint(cr);
+                cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+                document.draw(cr, slot->params, render_options);
+                cairo_destroy(cr);
+                cairo_surface_flush(slot->surface);
+            }));
+        }
+
+        while(!in_flight.empty()) {
+            encode_next();
+        }
+    } catch(...) {
+        // wait for the remaining frames before their surfaces are released
+        for(auto& f : in_flight) {
+            f.second.wait();
+        }
+        for(auto& slot : slots) {
+            cairo_surface_destroy(slot.surface);
+        }
+        throw;
+    }
+
+    for(auto& slot : slots) {
+        cairo_surface_destroy(slot.surface);
+    }
+}
+
+/*
+ * @fn render
+ *
+ * @brief render frames using a keyframe table
+ *
+ * @param nr_frames number of frames
+ * @param keyframes keyframe table
+ * @param encoder   function receiving the finished frames in order
+ *
+ */
+void Svg2Cairo::FrameSequence::render(unsigned int nr_frames, const KeyframeTable& keyframes, const FrameEncoder& encoder) const {
+    this->render(nr_frames, [&keyframes](unsigned int frame, FrameParameters& params) {
+        keyframes.apply(frame, params);
+    }, encoder);
+}
+
+/*
+ * @fn png_encoder
+ *
+ * @brief create an encoder writing every frame to a PNG file
+ *
+ * @param pattern   boost::format pattern for the filename, e.g. "frame_%04i.png"
+ *
+ * @return encoder
+ */
+Svg2Cairo::FrameSequence::FrameEncoder Svg2Cairo::FrameSequence::png_encoder(const std::string& pattern) {
+    return [pattern](unsigned int frame, cairo_surface_t* surface) {
+        const std::string filename = (boost::format(pattern) % frame).str();
+        if(cairo_surface_write_to_png(surface, filename.c_str()) != CAIRO_STATUS_SUCCESS) {
+            throw std::runtime_error("Could not write frame to " + filename);
+        }
+    };
+}
@@ -0,0 +1,278 @@
+/************************************************************************************
+ *   animation.h  --  This file is part of LIBYASVG.                                *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _ANIMATION
+#define _ANIMATION
+
+#include <cairo.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "color.h"
+#include "svg2cairo.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * SHAPE PARAMETERS
+ *****************************************************************/
+
+/*
+ * @class ShapeParameters
+ *
+ * @brief per-frame overrides for a single shape
+ *
+ */
+struct ShapeParameters {
+    bool has_transform = false;     //!< whether transform is applied
+    cairo_matrix_t transform;       //!< transform applied on top of the shape's own transform
+    bool has_color = false;         //!< whether color replaces the shape's own color
+    Color color;                    //!< fill color for this frame
+};
+
+/*****************************************************************
+ * FRAME PARAMETERS
+ *****************************************************************/
+
+/*
+ * @class FrameParameters
+ *
+ * @brief set of shape overrides used to draw a single frame
+ *
+ * Shapes are identified by their index in the document (see
+ * Svg2Cairo::get_nr_shapes). Shapes without overrides are drawn as
+ * they appear in the document.
+ *
+ */
+class FrameParameters {
+private:
+    std::vector<ShapeParameters> shapes;    //!< overrides indexed by shape
+    std::vector<bool> active;               //!< whether a shape carries overrides
+
+public:
+    /*
+     * @fn set_transform
+     *
+     * @brief apply an additional transformation to a shape
+     *
+     * @param idx       shape index
+     * @param matrix    transformation matrix
+     *
+     */
+    void set_transform(size_t idx, const cairo_matrix_t& matrix);
+
+    /*
+     * @fn set_color
+     *
+     * @brief replace the fill color of a shape
+     *
+     * @param idx       shape index
+     * @param _color    fill color
+     *
+     */
+    void set_color(size_t idx, const Color& _color);
+
+    /*
+     * @fn get
+     *
+     * @brief get the overrides for a shape
+     *
+     * @param idx       shape index
+     *
+     * @return pointer to overrides or nullptr when the shape is untouched
+     */
+    inline const ShapeParameters* get(size_t idx) const {
+        return (idx < this->active.size() && this->active[idx]) ? &this->shapes[idx] : nullptr;
+    }
+
+    /*
+     * @fn clear
+     *
+     * @brief remove all overrides
+     *
+     */
+    void clear();
+
+private:
+    ShapeParameters& fetch(size_t idx);
+};
+
+/*****************************************************************
+ * KEYFRAME TABLE
+ *****************************************************************/
+
+/*
+ * @class Keyframe
+ *
+ * @brief state of a shape at a specific frame
+ *
+ */
+struct Keyframe {
+    unsigned int frame = 0;     //!< frame number
+    double tx = 0.0;            //!< translation in x
+    double ty = 0.0;            //!< translation in y
+    double angle = 0.0;         //!< rotation angle in degrees
+    double scale = 1.0;         //!< uniform scaling factor
+    bool has_color = false;     //!< whether the color is animated
+    Color color;                //!< fill color
+};
+
+/*
+ * @class KeyframeTable
+ *
+ * @brief per-shape keyframes which are linearly interpolated
+ *
+ */
+class KeyframeTable {
+private:
+    std::map<size_t, std::vector<Keyframe> > tracks;    //!< keyframes (sorted by frame) per shape
+
+public:
+    /*
+     * @fn add_keyframe
+     *
+     * @brief add a keyframe for a shape
+     *
+     * @param idx       shape index
+     * @param keyframe  keyframe
+     *
+     */
+    void add_keyframe(size_t idx, const Keyframe& keyframe);
+
+    /*
+     * @fn apply
+     *
+     * @brief set the interpolated overrides of all animated shapes
+     *
+     * Frames before the first or after the last keyframe take the
+     * state of that keyframe.
+     *
+     * @param frame     frame number
+     * @param params    frame parameters to fill
+     *
+     */
+    void apply(unsigned int frame, FrameParameters& params) const;
+};
+
+/*****************************************************************
+ * FRAME SEQUENCE
+ *****************************************************************/
+
+/*
+ * @class FrameSequence
+ *
+ * @brief render a sequence of frames of a single document
+ *
+ * Frames are rendered concurrently on a worker pool, each into one
+ * surface of a fixed set of surfaces. Finished frames are handed to
+ * the encoder in frame order on the calling thread, after which their
+ * surface is recycled. A new frame is only started when a surface is
+ * available, so memory use is bounded by the number of surfaces and
+ * not by the number of frames.
+ *
+ */
+class FrameSequence {
+public:
+    typedef std::function<void(unsigned int, FrameParameters&)> FrameCallback;
+    typedef std::function<void(unsigned int, cairo_surface_t*)> FrameEncoder;
+
+private:
+    const Svg2Cairo& doc;           //!< document to render
+    unsigned int width;             //!< width of a frame in pixels
+    unsigned int height;            //!< height of a frame in pixels
+    unsigned int nr_threads;        //!< number of worker threads (0: hardware concurrency)
+    unsigned int nr_surfaces;       //!< number of surfaces (0: twice the number of threads)
+    RenderOptions options;          //!< accuracy settings of the frames
+
+public:
+    /*
+     * @fn FrameSequence
+     *
+     * @brief FrameSequence constructor
+     *
+     * @param _doc      document to render (must outlive the sequence)
+     * @param _width    width of a frame in pixels
+     * @param _height   height of a frame in pixels
+     *
+     */
+    FrameSequence(const Svg2Cairo& _doc, unsigned int _width, unsigned int _height);
+
+    inline void set_nr_threads(unsigned int _nr_threads) {
+        this->nr_threads = _nr_threads;
+    }
+
+    inline void set_nr_surfaces(unsigned int _nr_surfaces) {
+        this->nr_surfaces = _nr_surfaces;
+    }
+
+    inline void set_render_options(const RenderOptions& _options) {
+        this->options = _options;
+    }
+
+    /*
+     * @fn render
+     *
+     * @brief render frames using a parameter callback
+     *
+     * The callback is executed on the calling thread in frame order and
+     * does therefore not have to be thread-safe.
+     *
+     * @param nr_frames number of frames
+     * @param callback  function filling the parameters of a frame
+     * @param encoder   function receiving the finished frames in order
+     *
+     */
+    void render(unsigned int nr_frames, const FrameCallback& callback, const FrameEncoder& encoder) const;
+
+    /*
+     * @fn render
+     *
+     * @brief render frames using a keyframe table
+     *
+     * @param nr_frames number of frames
+     * @param keyframes keyframe table
+     * @param encoder   function receiving the finished frames in order
+     *
+     */
+    void render(unsigned int nr_frames, const KeyframeTable& keyframes, const FrameEncoder& encoder) const;
+
+    /*
+     * @fn png_encoder
+     *
+     * @brief create an encoder writing every frame to a PNG file
+     *
+     * @param pattern   boost::format pattern for the filename, e.g. "frame_%04i.png"
+     *
+     * @return encoder
+     */
+    static FrameEncoder png_encoder(const std::string& pattern);
+};
+
+} // Svg2Cairo::
+
+#endif //_ANIMATION
@@ -0,0 +1,90 @@
+/************************************************************************************
+ *   arena.cpp  --  This file is part of LIBYASVG.                                  *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "arena.h"
+
+/*****************************************************************
+ * ARENA
+ *****************************************************************/
+
+// size of the first block; subsequent blocks grow geometrically
+static const size_t ARENA_INITIAL_BLOCK = 64 * 1024;
+
+/*
+ * @fn Arena
+ *
+ * @brief Arena constructor
+ *
+ * @param _upstream resource providing the blocks (nullptr uses new/delete)
+ *
+ */
+Svg2Cairo::Arena::Arena(std::pmr::memory_resource* _upstream) :
+    upstream(_upstream != nullptr ? _upstream : std::pmr::new_delete_resource()),
+    buffer(ARENA_INITIAL_BLOCK, &this->upstream),
+    nr_bytes_allocated(0) {}
+
+size_t Svg2Cairo::Arena::get_bytes_allocated() const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    return this->nr_bytes_allocated;
+}
+
+size_t Svg2Cairo::Arena::get_bytes_reserved() const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    return this->upstream.get_nr_bytes();
+}
+
+void* Svg2Cairo::Arena::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->nr_bytes_allocated += bytes;
+    return this->buffer.allocate(bytes, alignment);
+}
+
+void Svg2Cairo::Arena::do_deallocate(void*, size_t, size_t) {
+    // memory is released when the arena is destroyed
+}
+
+bool Svg2Cairo::Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+/*****************************************************************
+ * ARENA UPSTREAM
+ *****************************************************************/
+
+void* Svg2Cairo::Arena::Upstream::do_allocate(size_t bytes, size_t alignment) {
+    void* p = this->resource->allocate(bytes, alignment);
+    this->nr_bytes += bytes;
+    return p;
+}
+
+void Svg2Cairo::Arena::Upstream::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    this->resource->deallocate(p, bytes, alignment);
+    this->nr_bytes -= bytes;
+}
+
+bool Svg2Cairo::Arena::Upstream::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,125 @@
+/************************************************************************************
+ *   arena.h  --  This file is part of LIBYASVG.                                    *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _ARENA
+#define _ARENA
+
+#include <memory_resource>
+#include <mutex>
+#include <cstddef>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * ARENA
+ *****************************************************************/
+
+/*
+ * @class Arena
+ *
+ * @brief monotonic memory resource holding all data of a single document
+ *
+ * Memory is obtained from the upstream resource in a few large blocks
+ * and is only returned when the arena is destroyed. Individual
+ * deallocations are ignored. Allocation is thread-safe, such that
+ * shapes can be converted concurrently and compiled lazily while
+ * rendering.
+ *
+ */
+class Arena : public std::pmr::memory_resource {
+private:
+    /*
+     * @class Upstream
+     *
+     * @brief forwards block allocations to the upstream resource and counts them
+     *
+     */
+    class Upstream : public std::pmr::memory_resource {
+    private:
+        std::pmr::memory_resource* resource;        //!< resource providing the blocks
+        size_t nr_bytes;                            //!< bytes currently obtained
+
+    public:
+        Upstream(std::pmr::memory_resource* _resource) : resource(_resource), nr_bytes(0) {}
+
+        inline size_t get_nr_bytes() const {
+            return this->nr_bytes;
+        }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    Upstream upstream;                              //!< source of the blocks (constructed before the buffer)
+    std::pmr::monotonic_buffer_resource buffer;     //!< hands out memory from the blocks
+    mutable std::mutex mtx;                         //!< guards the buffer and the counters
+    size_t nr_bytes_allocated;                      //!< bytes handed out to the document
+
+public:
+    /*
+     * @fn Arena
+     *
+     * @brief Arena constructor
+     *
+     * @param _upstream resource providing the blocks (nullptr uses new/delete)
+     *
+     */
+    Arena(std::pmr::memory_resource* _upstream = nullptr);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /*
+     * @fn get_bytes_allocated
+     *
+     * @brief get the number of bytes requested from the arena
+     *
+     */
+    size_t get_bytes_allocated() const;
+
+    /*
+     * @fn get_bytes_reserved
+     *
+     * @brief get the number of bytes obtained from the upstream resource
+     *
+     */
+    size_t get_bytes_reserved() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+} // Svg2Cairo::
+
+#endif //_ARENA
@@ -0,0 +1,148 @@
+/************************************************************************************
+ *   bench_kernels.cpp  --  This file is part of LIBYASVG.                          *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+/*
+ * Microbenchmark of the bulk geometry kernels
+ *
+ * Every kernel is timed for each instruction set the processor supports
+ * and compared with the scalar version. The results of the vector
+ * kernels are also checked to be identical to the scalar ones.
+ *
+ * usage: bench_kernels [number of points]
+ */
+
+#include "kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    volatile double sink;   //!< keeps the compiler from removing the benchmarked calls
+
+    /*
+     * @fn measure
+     *
+     * @brief best time per call (in ns) over a number of repetitions
+     *
+     */
+    template<typename Function>
+    double measure(Function&& f, unsigned int calls) {
+        double best = 1e300;
+        for(unsigned int r=0; r<5; r++) {
+            const auto start = Clock::now();
+            for(unsigned int i=0; i<calls; i++) {
+                f();
+            }
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            best = std::min(best, elapsed.count() / calls);
+        }
+        return best;
+    }
+
+    /*
+     * @fn report
+     *
+     * @brief print the timing of one kernel for one instruction set
+     *
+     */
+    void report(const char* kernel, Svg2Cairo::KernelSet set, double ns, double scalar_ns, size_t items, bool identical) {
+        printf("%-18s %-8s %10.1f ns %8.3f ns/item %6.2fx %s\n",
+               kernel, Svg2Cairo::get_kernel_name(set), ns, ns / items,
+               scalar_ns / ns, identical ? "" : "MISMATCH");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t n = std::max<size_t>(1, argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096);
+    const unsigned int calls = std::max<size_t>(1, (1 << 24) / std::max<size_t>(n, 1));
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-500.0, 500.0);
+    std::vector<double> pts(2 * n);
+    for(double& v : pts) {
+        v = dist(rng);
+    }
+
+    cairo_matrix_t m;
+    m.xx = 0.8;  m.yx = 0.6;
+    m.xy = -0.6; m.yy = 0.8;
+    m.x0 = 12.5; m.y0 = -3.25;
+
+    const double ctrl[8] = {0.0, 0.0, 100.0, 250.0, 300.0, -50.0, 400.0, 120.0};
+    const unsigned int segments = std::max<size_t>(2, n);
+
+    const Svg2Cairo::KernelSet best = Svg2Cairo::get_best_kernel_set();
+    printf("points: %zu, best instruction set: %s\n\n", n, Svg2Cairo::get_kernel_name(best));
+
+    // results and timings of the scalar kernels serve as reference
+    std::vector<double> ref_transform(2 * n), ref_cubic(2 * (segments - 1));
+    Svg2Cairo::BoundingBox ref_box;
+    double scalar_transform = 0.0, scalar_bounds = 0.0, scalar_cubic = 0.0;
+
+    for(int s=Svg2Cairo::KERNELS_SCALAR; s<=best; s++) {
+        const Svg2Cairo::KernelSet set = Svg2Cairo::set_kernel_set((Svg2Cairo::KernelSet)s);
+
+        std::vector<double> out(2 * n);
+        const double t_transform = measure([&]() {
+            Svg2Cairo::transform_points(m, pts.data(), out.data(), n);
+            sink = out[0];
+        }, calls);
+
+        Svg2Cairo::BoundingBox box;
+        const double t_bounds = measure([&]() {
+            box = Svg2Cairo::point_bounds(pts.data(), n);
+            sink = box.x1;
+        }, calls);
+
+        std::vector<double> cubic(2 * (segments - 1));
+        const double t_cubic = measure([&]() {
+            Svg2Cairo::evaluate_cubic(ctrl, segments, cubic.data());
+            sink = cubic[0];
+        }, calls);
+
+        if(set == Svg2Cairo::KERNELS_SCALAR) {
+            ref_transform = out;
+            ref_box = box;
+            ref_cubic = cubic;
+            scalar_transform = t_transform;
+            scalar_bounds = t_bounds;
+            scalar_cubic = t_cubic;
+        }
+
+        const bool same_box = std::memcmp(&box, &ref_box, sizeof(box)) == 0;
+        report("transform_points", set, t_transform, scalar_transform, n, out == ref_transform);
+        report("point_bounds", set, t_bounds, scalar_bounds, n, same_box);
+        report("evaluate_cubic", set, t_cubic, scalar_cubic, segments - 1, cubic == ref_cubic);
+    }
+
+    return 0;
+}
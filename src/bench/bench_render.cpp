@@ -0,0 +1,116 @@
+/************************************************************************************
+ *   bench_render.cpp  --  This file is part of LIBYASVG.                           *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+/*
+ * Render benchmark over a set of documents
+ *
+ * Every document is loaded and drawn a number of times onto an ARGB32
+ * surface; the best load and draw times are reported per document. The
+ * benchmark also serves as training workload of the profile-guided build
+ * (see YASVG_PGO in CMakeLists.txt).
+ *
+ * usage: bench_render [-n repetitions] [-s size] file.svg [file.svg ...]
+ */
+
+#include "svg2cairo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /*
+     * @fn elapsed_ms
+     *
+     * @brief time passed since a point in time in milliseconds
+     *
+     */
+    double elapsed_ms(const Clock::time_point& start) {
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int repetitions = 10;
+    int size = 500;
+    std::vector<std::string> files;
+
+    for(int i=1; i<argc; i++) {
+        if(std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            size = std::max(1, std::atoi(argv[++i]));
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if(files.empty()) {
+        fprintf(stderr, "usage: bench_render [-n repetitions] [-s size] file.svg [file.svg ...]\n");
+        return 1;
+    }
+
+    printf("%-40s %8s %12s %12s\n", "document", "shapes", "load (ms)", "draw (ms)");
+    int status = 0;
+    for(const std::string& file : files) {
+        try {
+            double best_load = 1e300;
+            double best_draw = 1e300;
+            size_t nr_shapes = 0;
+
+            for(unsigned int r=0; r<repetitions; r++) {
+                auto start = Clock::now();
+                Svg2Cairo::Svg2Cairo svg(file);
+                best_load = std::min(best_load, elapsed_ms(start));
+                nr_shapes = svg.get_nr_shapes();
+
+                auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+                auto cr = cairo_create(surface);
+                start = Clock::now();
+                svg.draw(cr);
+                cairo_surface_flush(surface);
+                best_draw = std::min(best_draw, elapsed_ms(start));
+                cairo_destroy(cr);
+                cairo_surface_destroy(surface);
+            }
+
+            printf("%-40s %8zu %12.3f %12.3f\n", file.c_str(), nr_shapes, best_load, best_draw);
+        } catch(const std::exception& e) {
+            fprintf(stderr, "%s: %s\n", file.c_str(), e.what());
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,374 @@
+/************************************************************************************
+ *   regress.cpp  --  This file is part of LIBYASVG.                                *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+/*
+ * Rendering and performance regression check over a corpus of documents
+ *
+ * Every document is drawn onto an ARGB32 surface and compared pixel by
+ * pixel against its golden image (golden/<name>.png). Pixels of which a
+ * channel deviates more than the tolerance count as different; when more
+ * pixels differ than allowed, the rendered image and a diff image (red
+ * for different pixels over a faded copy of the golden image) are written
+ * to the output directory. The best draw time of a number of repetitions
+ * is compared against the baseline in golden/timings.txt; a document
+ * fails when it is slower than the baseline by more than the threshold.
+ * A document without a baseline entry is only drawn; one without a golden
+ * image fails.
+ *
+ * With -u, the golden images and baseline are (re)written from the
+ * current build instead.
+ *
+ * usage: regress [-u] [-g golden] [-o output] [-n repetitions] [-s size]
+ *                [-t tolerance] [-p pixels] [-r threshold] [-m ms] file.svg [...]
+ */
+
+#include "svg2cairo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using SurfacePtr = std::unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>;
+
+    struct Settings {
+        bool update = false;                //!< write golden images and baseline instead of checking
+        std::string golden_dir = ".";       //!< directory of the golden images and baseline
+        std::string output_dir = ".";       //!< directory receiving the images of failed documents
+        unsigned int repetitions = 10;      //!< number of draws of which the best time counts
+        int size = 500;                     //!< width and height of the surface
+        unsigned int tolerance = 2;         //!< allowed deviation of a color channel
+        size_t max_pixels = 0;              //!< allowed number of different pixels
+        double threshold = 0.25;            //!< allowed relative increase of the draw time
+        double min_ms = 0.1;                //!< increases of the draw time below this are ignored
+    };
+
+    struct Comparison {
+        size_t nr_different = 0;            //!< number of pixels deviating beyond the tolerance
+        unsigned int max_deviation = 0;     //!< largest deviation of any channel
+    };
+
+    /*
+     * @fn elapsed_ms
+     *
+     * @brief time passed since a point in time in milliseconds
+     *
+     */
+    double elapsed_ms(const Clock::time_point& start) {
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+
+    /*
+     * @fn get_name
+     *
+     * @brief name of a document in the corpus: its file name without directory and extension
+     *
+     */
+    std::string get_name(const std::string& file) {
+        const size_t slash = file.find_last_of("/\\");
+        std::string name = (slash == std::string::npos) ? file : file.substr(slash + 1);
+        const size_t dot = name.rfind('.');
+        if(dot != std::string::npos && dot > 0) {
+            name.erase(dot);
+        }
+        return name;
+    }
+
+    /*
+     * @fn read_baseline
+     *
+     * @brief read draw times (name milliseconds per line), an absent file is an empty baseline
+     *
+     */
+    std::map<std::string, double> read_baseline(const std::string& filename) {
+        std::map<std::string, double> baseline;
+        std::ifstream in(filename);
+        std::string name;
+        double ms;
+        while(in >> name >> ms) {
+            baseline[name] = ms;
+        }
+        return baseline;
+    }
+
+    /*
+     * @fn write_baseline
+     *
+     * @brief write draw times (name milliseconds per line)
+     *
+     */
+    void write_baseline(const std::string& filename, const std::map<std::string, double>& baseline) {
+        std::ofstream out(filename);
+        for(const auto& entry : baseline) {
+            out << entry.first << " " << entry.second << "\n";
+        }
+        if(!out) {
+            throw std::runtime_error("cannot write " + filename);
+        }
+    }
+
+    /*
+     * @fn write_png
+     *
+     * @brief write a surface to a png file
+     *
+     */
+    void write_png(cairo_surface_t* surface, const std::string& filename) {
+        if(cairo_surface_write_to_png(surface, filename.c_str()) != CAIRO_STATUS_SUCCESS) {
+            throw std::runtime_error("cannot write " + filename);
+        }
+    }
+
+    /*
+     * @fn render
+     *
+     * @brief draw a document a number of times and return the best draw time, the last image is kept
+     *
+     */
+    double render(const Svg2Cairo::Svg2Cairo& svg, const Settings& settings, SurfacePtr& image) {
+        double best = 1e300;
+        for(unsigned int r=0; r<settings.repetitions; r++) {
+            SurfacePtr surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, settings.size, settings.size),
+                               cairo_surface_destroy);
+            auto cr = cairo_create(surface.get());
+            const auto start = Clock::now();
+            svg.draw(cr);
+            cairo_surface_flush(surface.get());
+            best = std::min(best, elapsed_ms(start));
+            cairo_destroy(cr);
+            image = std::move(surface);
+        }
+        return best;
+    }
+
+    /*
+     * @fn compare
+     *
+     * @brief compare two ARGB32 images of equal size, optionally producing a diff image
+     *
+     */
+    Comparison compare(cairo_surface_t* image, cairo_surface_t* golden, unsigned int tolerance, cairo_surface_t* diff) {
+        Comparison result;
+        const int width = cairo_image_surface_get_width(image);
+        const int height = cairo_image_surface_get_height(image);
+        const unsigned char* data = cairo_image_surface_get_data(image);
+        const unsigned char* ref = cairo_image_surface_get_data(golden);
+        unsigned char* out = diff ? cairo_image_surface_get_data(diff) : nullptr;
+        const int stride = cairo_image_surface_get_stride(image);
+        const int ref_stride = cairo_image_surface_get_stride(golden);
+        const int out_stride = diff ? cairo_image_surface_get_stride(diff) : 0;
+
+        for(int y=0; y<height; y++) {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(data + y * stride);
+            const uint32_t* ref_row = reinterpret_cast<const uint32_t*>(ref + y * ref_stride);
+            uint32_t* out_row = out ? reinterpret_cast<uint32_t*>(out + y * out_stride) : nullptr;
+            for(int x=0; x<width; x++) {
+                unsigned int deviation = 0;
+                for(unsigned int shift=0; shift<32; shift+=8) {
+                    const int a = (row[x] >> shift) & 0xff;
+                    const int b = (ref_row[x] >> shift) & 0xff;
+                    deviation = std::max(deviation, static_cast<unsigned int>(std::abs(a - b)));
+                }
+                result.max_deviation = std::max(result.max_deviation, deviation);
+                const bool different = deviation > tolerance;
+                result.nr_different += different;
+
+                if(out_row) {
+                    if(different) {
+                        out_row[x] = 0xffff0000;
+                    } else {
+                        // golden pixel over white as gray, faded to a quarter of its contrast
+                        const uint32_t p = ref_row[x];
+                        const unsigned int white = 255 - (p >> 24);
+                        const unsigned int gray = (((p >> 16) & 0xff) + ((p >> 8) & 0xff) + (p & 0xff)) / 3 + white;
+                        const uint32_t v = 255 - (255 - std::min(gray, 255u)) / 4;
+                        out_row[x] = 0xff000000 | (v << 16) | (v << 8) | v;
+                    }
+                }
+            }
+        }
+
+        if(diff) {
+            cairo_surface_mark_dirty(diff);
+        }
+        return result;
+    }
+
+    /*
+     * @fn usage
+     *
+     * @brief print the command line arguments
+     *
+     */
+    void usage() {
+        fprintf(stderr, "usage: regress [-u] [-g golden] [-o output] [-n repetitions] [-s size]\n"
+                        "               [-t tolerance] [-p pixels] [-r threshold] [-m ms] file.svg [...]\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    std::vector<std::string> files;
+
+    for(int i=1; i<argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if(std::strcmp(argv[i], "-u") == 0) {
+            settings.update = true;
+        } else if(std::strcmp(argv[i], "-g") == 0 && has_value) {
+            settings.golden_dir = argv[++i];
+        } else if(std::strcmp(argv[i], "-o") == 0 && has_value) {
+            settings.output_dir = argv[++i];
+        } else if(std::strcmp(argv[i], "-n") == 0 && has_value) {
+            settings.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "-s") == 0 && has_value) {
+            settings.size = std::max(1, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "-t") == 0 && has_value) {
+            settings.tolerance = std::max(0, std::atoi(argv[++i]));
+        } else if(std::strcmp(argv[i], "-p") == 0 && has_value) {
+            settings.max_pixels = std::strtoul(argv[++i], nullptr, 10);
+        } else if(std::strcmp(argv[i], "-r") == 0 && has_value) {
+            settings.threshold = std::max(0.0, std::atof(argv[++i]));
+        } else if(std::strcmp(argv[i], "-m") == 0 && has_value) {
+            settings.min_ms = std::max(0.0, std::atof(argv[++i]));
+        } else if(argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if(files.empty()) {
+        usage();
+        return 1;
+    }
+
+    const std::string baseline_file = settings.golden_dir + "/timings.txt";
+    std::map<std::string, double> baseline = read_baseline(baseline_file);
+
+    printf("%-24s %10s %12s %14s  %s\n", "document", "pixels", "draw (ms)", "baseline (ms)", "result");
+    int status = 0;
+    for(const std::string& file : files) {
+        const std::string name = get_name(file);
+        const std::string golden_file = settings.golden_dir + "/" + name + ".png";
+        try {
+            Svg2Cairo::Svg2Cairo svg(file);
+            SurfacePtr image(nullptr, cairo_surface_destroy);
+            const double ms = render(svg, settings, image);
+
+            if(settings.update) {
+                write_png(image.get(), golden_file);
+                baseline[name] = ms;
+                printf("%-24s %10s %12.3f %14s  %s\n", name.c_str(), "-", ms, "-", "updated");
+                continue;
+            }
+
+            std::vector<std::string> failures;
+            std::string pixels = "-";
+
+            SurfacePtr golden(cairo_image_surface_create_from_png(golden_file.c_str()), cairo_surface_destroy);
+            if(cairo_surface_status(golden.get()) != CAIRO_STATUS_SUCCESS) {
+                failures.push_back("no golden image " + golden_file);
+            } else if(cairo_image_surface_get_width(golden.get()) != settings.size ||
+                      cairo_image_surface_get_height(golden.get()) != settings.size) {
+                failures.push_back("golden image size differs");
+            } else {
+                // golden images without transparency are read as RGB24; the unused byte then need not be 0xff
+                if(cairo_image_surface_get_format(golden.get()) != CAIRO_FORMAT_ARGB32) {
+                    SurfacePtr converted(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, settings.size, settings.size),
+                                         cairo_surface_destroy);
+                    auto cr = cairo_create(converted.get());
+                    cairo_set_source_surface(cr, golden.get(), 0, 0);
+                    cairo_paint(cr);
+                    cairo_destroy(cr);
+                    cairo_surface_flush(converted.get());
+                    golden = std::move(converted);
+                }
+
+                Comparison result = compare(image.get(), golden.get(), settings.tolerance, nullptr);
+                pixels = std::to_string(result.nr_different);
+                if(result.nr_different > settings.max_pixels) {
+                    SurfacePtr diff(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, settings.size, settings.size),
+                                    cairo_surface_destroy);
+                    cairo_surface_flush(diff.get());
+                    compare(image.get(), golden.get(), settings.tolerance, diff.get());
+                    write_png(image.get(), settings.output_dir + "/" + name + ".png");
+                    write_png(diff.get(), settings.output_dir + "/" + name + ".diff.png");
+                    failures.push_back(pixels + " pixels differ (max deviation " + std::to_string(result.max_deviation) +
+                                       "), see " + settings.output_dir + "/" + name + ".diff.png");
+                }
+            }
+
+            const auto reference = baseline.find(name);
+            char reference_ms[32] = "no baseline";
+            if(reference != baseline.end()) {
+                snprintf(reference_ms, sizeof(reference_ms), "%.3f", reference->second);
+                const double allowed = reference->second * (1.0 + settings.threshold);
+                if(ms > allowed && ms - reference->second > settings.min_ms) {
+                    char message[96];
+                    snprintf(message, sizeof(message), "%.0f%% slower than baseline",
+                             100.0 * (ms / reference->second - 1.0));
+                    failures.push_back(message);
+                }
+            }
+
+            printf("%-24s %10s %12.3f %14s  %s\n", name.c_str(), pixels.c_str(), ms, reference_ms,
+                   failures.empty() ? "ok" : "FAIL");
+            for(const std::string& failure : failures) {
+                printf("    %s\n", failure.c_str());
+            }
+            if(!failures.empty()) {
+                status = 1;
+            }
+        } catch(const std::exception& e) {
+            fprintf(stderr, "%s: %s\n", file.c_str(), e.what());
+            status = 1;
+        }
+    }
+
+    if(settings.update) {
+        try {
+            write_baseline(baseline_file, baseline);
+        } catch(const std::exception& e) {
+            fprintf(stderr, "%s\n", e.what());
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,90 @@
+/************************************************************************************
+ *   cancellation.h  --  This file is part of LIBYASVG.                             *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _CANCELLATION
+#define _CANCELLATION
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * CANCELLATION
+ *****************************************************************/
+
+/*
+ * @class CancellationToken
+ *
+ * @brief flag by which a request can be abandoned from another thread
+ *
+ * Copies of a token share the flag, so the caller keeps one copy and
+ * passes another along with the request.
+ *
+ */
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool> > flag;   //!< set once the request is cancelled
+
+public:
+    CancellationToken() : flag(std::make_shared<std::atomic<bool> >(false)) {}
+
+    /*
+     * @fn cancel
+     *
+     * @brief request that the work is abandoned
+     *
+     */
+    inline void cancel() {
+        this->flag->store(true, std::memory_order_relaxed);
+    }
+
+    /*
+     * @fn is_cancelled
+     *
+     * @brief whether the work has been cancelled
+     *
+     */
+    inline bool is_cancelled() const {
+        return this->flag->load(std::memory_order_relaxed);
+    }
+};
+
+/*
+ * @class CancelledError
+ *
+ * @brief reported by a request that was abandoned through its token
+ *
+ */
+class CancelledError : public std::runtime_error {
+public:
+    CancelledError() : std::runtime_error("request cancelled") {}
+};
+
+} // Svg2Cairo::
+
+#endif //_CANCELLATION
@@ -18,36 +18,459 @@
 
 #include "color.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    /*
+     * @class NamedColor
+     *
+     * @brief entry of the table of CSS named colors
+     *
+     */
+    struct NamedColor {
+        const char* name;   // lowercase name
+        uint32_t rgba;      // packed color
+    };
+
+    // CSS named colors, sorted by name for binary search
+    constexpr NamedColor named_colors[] = {
+        {"aliceblue", 0xF0F8FFFF},
+        {"antiquewhite", 0xFAEBD7FF},
+        {"aqua", 0x00FFFFFF},
+        {"aquamarine", 0x7FFFD4FF},
+        {"azure", 0xF0FFFFFF},
+        {"beige", 0xF5F5DCFF},
+        {"bisque", 0xFFE4C4FF},
+        {"black", 0x000000FF},
+        {"blanchedalmond", 0xFFEBCDFF},
+        {"blue", 0x0000FFFF},
+        {"blueviolet", 0x8A2BE2FF},
+        {"brown", 0xA52A2AFF},
+        {"burlywood", 0xDEB887FF},
+        {"cadetblue", 0x5F9EA0FF},
+        {"chartreuse", 0x7FFF00FF},
+        {"chocolate", 0xD2691EFF},
+        {"coral", 0xFF7F50FF},
+        {"cornflowerblue", 0x6495EDFF},
+        {"cornsilk", 0xFFF8DCFF},
+        {"crimson", 0xDC143CFF},
+        {"cyan", 0x00FFFFFF},
+        {"darkblue", 0x00008BFF},
+        {"darkcyan", 0x008B8BFF},
+        {"darkgoldenrod", 0xB8860BFF},
+        {"darkgray", 0xA9A9A9FF},
+        {"darkgreen", 0x006400FF},
+        {"darkgrey", 0xA9A9A9FF},
+        {"darkkhaki", 0xBDB76BFF},
+        {"darkmagenta", 0x8B008BFF},
+        {"darkolivegreen", 0x556B2FFF},
+        {"darkorange", 0xFF8C00FF},
+        {"darkorchid", 0x9932CCFF},
+        {"darkred", 0x8B0000FF},
+        {"darksalmon", 0xE9967AFF},
+        {"darkseagreen", 0x8FBC8FFF},
+        {"darkslateblue", 0x483D8BFF},
+        {"darkslategray", 0x2F4F4FFF},
+        {"darkslategrey", 0x2F4F4FFF},
+        {"darkturquoise", 0x00CED1FF},
+        {"darkviolet", 0x9400D3FF},
+        {"deeppink", 0xFF1493FF},
+        {"deepskyblue", 0x00BFFFFF},
+        {"dimgray", 0x696969FF},
+        {"dimgrey", 0x696969FF},
+        {"dodgerblue", 0x1E90FFFF},
+        {"firebrick", 0xB22222FF},
+        {"floralwhite", 0xFFFAF0FF},
+        {"forestgreen", 0x228B22FF},
+        {"fuchsia", 0xFF00FFFF},
+        {"gainsboro", 0xDCDCDCFF},
+        {"ghostwhite", 0xF8F8FFFF},
+        {"gold", 0xFFD700FF},
+        {"goldenrod", 0xDAA520FF},
+        {"gray", 0x808080FF},
+        {"green", 0x008000FF},
+        {"greenyellow", 0xADFF2FFF},
+        {"grey", 0x808080FF},
+        {"honeydew", 0xF0FFF0FF},
+        {"hotpink", 0xFF69B4FF},
+        {"indianred", 0xCD5C5CFF},
+        {"indigo", 0x4B0082FF},
+        {"ivory", 0xFFFFF0FF},
+        {"khaki", 0xF0E68CFF},
+        {"lavender", 0xE6E6FAFF},
+        {"lavenderblush", 0xFFF0F5FF},
+        {"lawngreen", 0x7CFC00FF},
+        {"lemonchiffon", 0xFFFACDFF},
+        {"lightblue", 0xADD8E6FF},
+        {"lightcoral", 0xF08080FF},
+        {"lightcyan", 0xE0FFFFFF},
+        {"lightgoldenrodyellow", 0xFAFAD2FF},
+        {"lightgray", 0xD3D3D3FF},
+        {"lightgreen", 0x90EE90FF},
+        {"lightgrey", 0xD3D3D3FF},
+        {"lightpink", 0xFFB6C1FF},
+        {"lightsalmon", 0xFFA07AFF},
+        {"lightseagreen", 0x20B2AAFF},
+        {"lightskyblue", 0x87CEFAFF},
+        {"lightslategray", 0x778899FF},
+        {"lightslategrey", 0x778899FF},
+        {"lightsteelblue", 0xB0C4DEFF},
+        {"lightyellow", 0xFFFFE0FF},
+        {"lime", 0x00FF00FF},
+        {"limegreen", 0x32CD32FF},
+        {"linen", 0xFAF0E6FF},
+        {"magenta", 0xFF00FFFF},
+        {"maroon", 0x800000FF},
+        {"mediumaquamarine", 0x66CDAAFF},
+        {"mediumblue", 0x0000CDFF},
+        {"mediumorchid", 0xBA55D3FF},
+        {"mediumpurple", 0x9370DBFF},
+        {"mediumseagreen", 0x3CB371FF},
+        {"mediumslateblue", 0x7B68EEFF},
+        {"mediumspringgreen", 0x00FA9AFF},
+        {"mediumturquoise", 0x48D1CCFF},
+        {"mediumvioletred", 0xC71585FF},
+        {"midnightblue", 0x191970FF},
+        {"mintcream", 0xF5FFFAFF},
+        {"mistyrose", 0xFFE4E1FF},
+        {"moccasin", 0xFFE4B5FF},
+        {"navajowhite", 0xFFDEADFF},
+        {"navy", 0x000080FF},
+        {"oldlace", 0xFDF5E6FF},
+        {"olive", 0x808000FF},
+        {"olivedrab", 0x6B8E23FF},
+        {"orange", 0xFFA500FF},
+        {"orangered", 0xFF4500FF},
+        {"orchid", 0xDA70D6FF},
+        {"palegoldenrod", 0xEEE8AAFF},
+        {"palegreen", 0x98FB98FF},
+        {"paleturquoise", 0xAFEEEEFF},
+        {"palevioletred", 0xDB7093FF},
+        {"papayawhip", 0xFFEFD5FF},
+        {"peachpuff", 0xFFDAB9FF},
+        {"peru", 0xCD853FFF},
+        {"pink", 0xFFC0CBFF},
+        {"plum", 0xDDA0DDFF},
+        {"powderblue", 0xB0E0E6FF},
+        {"purple", 0x800080FF},
+        {"rebeccapurple", 0x663399FF},
+        {"red", 0xFF0000FF},
+        {"rosybrown", 0xBC8F8FFF},
+        {"royalblue", 0x4169E1FF},
+        {"saddlebrown", 0x8B4513FF},
+        {"salmon", 0xFA8072FF},
+        {"sandybrown", 0xF4A460FF},
+        {"seagreen", 0x2E8B57FF},
+        {"seashell", 0xFFF5EEFF},
+        {"sienna", 0xA0522DFF},
+        {"silver", 0xC0C0C0FF},
+        {"skyblue", 0x87CEEBFF},
+        {"slateblue", 0x6A5ACDFF},
+        {"slategray", 0x708090FF},
+        {"slategrey", 0x708090FF},
+        {"snow", 0xFFFAFAFF},
+        {"springgreen", 0x00FF7FFF},
+        {"steelblue", 0x4682B4FF},
+        {"tan", 0xD2B48CFF},
+        {"teal", 0x008080FF},
+        {"thistle", 0xD8BFD8FF},
+        {"tomato", 0xFF6347FF},
+        {"transparent", 0x00000000},
+        {"turquoise", 0x40E0D0FF},
+        {"violet", 0xEE82EEFF},
+        {"wheat", 0xF5DEB3FF},
+        {"white", 0xFFFFFFFF},
+        {"whitesmoke", 0xF5F5F5FF},
+        {"yellow", 0xFFFF00FF},
+        {"yellowgreen", 0x9ACD32FF},
+    };
+
+    constexpr size_t nr_named_colors = sizeof(named_colors) / sizeof(named_colors[0]);
+
+    constexpr int compare_names(const char* a, const char* b) {
+        while(*a != '\0' && *a == *b) {
+            ++a;
+            ++b;
+        }
+        return (unsigned char)*a - (unsigned char)*b;
+    }
+
+    constexpr bool named_colors_sorted() {
+        for(size_t i=1; i<nr_named_colors; i++) {
+            if(compare_names(named_colors[i-1].name, named_colors[i].name) >= 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(named_colors_sorted(), "named colors need to be sorted for binary search");
+
+    /*
+     * @fn compare_name
+     *
+     * @brief compare a range of characters case-insensitively with a lowercase name
+     *
+     */
+    int compare_name(const char* begin, const char* end, const char* name) {
+        for(; begin != end && *name != '\0'; ++begin, ++name) {
+            const int c = std::tolower((unsigned char)*begin);
+            if(c != *name) {
+                return c < *name ? -1 : 1;
+            }
+        }
+        if(begin != end) {
+            return 1;
+        }
+        return *name != '\0' ? -1 : 0;
+    }
+
+    int hex_value(char c) {
+        if(c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if(c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if(c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
+    void skip_spaces(const char*& p, const char* end) {
+        while(p != end && is_space(*p)) {
+            ++p;
+        }
+    }
+
+    unsigned int to_byte(double value) {
+        return (unsigned int)std::lround(std::min(255.0, std::max(0.0, value)));
+    }
+
+    /*
+     * @fn parse_number
+     *
+     * @brief parse a CSS number, optionally followed by a percent sign
+     *
+     * @param p         position in the string (advanced past the number)
+     * @param end       end of the string
+     * @param value     receives the number
+     * @param percent   receives whether a percent sign followed
+     *
+     * @return whether a number was found
+     */
+    bool parse_number(const char*& p, const char* end, double* value, bool* percent) {
+        double sign = 1.0;
+        if(p != end && (*p == '+' || *p == '-')) {
+            sign = (*p == '-') ? -1.0 : 1.0;
+            ++p;
+        }
+
+        double result = 0.0;
+        bool digits = false;
+        while(p != end && *p >= '0' && *p <= '9') {
+            result = 10.0 * result + (*p - '0');
+            digits = true;
+            ++p;
+        }
+        if(p != end && *p == '.') {
+            ++p;
+            double scale = 0.1;
+            while(p != end && *p >= '0' && *p <= '9') {
+                result += scale * (*p - '0');
+                scale *= 0.1;
+                digits = true;
+                ++p;
+            }
+        }
+        if(!digits) {
+            return false;
+        }
+
+        *percent = (p != end && *p == '%');
+        if(*percent) {
+            ++p;
+        }
+        *value = sign * result;
+        return true;
+    }
+
+    /*
+     * @fn parse_hex
+     *
+     * @brief parse the digits of #rgb, #rgba, #rrggbb or #rrggbbaa
+     *
+     */
+    bool parse_hex(const char* begin, const char* end, uint32_t* rgba) {
+        const size_t len = end - begin;
+        if(len != 3 && len != 4 && len != 6 && len != 8) {
+            return false;
+        }
+
+        unsigned int v[8];
+        for(size_t i=0; i<len; i++) {
+            const int h = hex_value(begin[i]);
+            if(h < 0) {
+                return false;
+            }
+            v[i] = h;
+        }
+
+        unsigned int c[4] = {0, 0, 0, 255};
+        if(len <= 4) {
+            // every digit is repeated, i.e. #abc equals #aabbcc
+            for(size_t i=0; i<len; i++) {
+                c[i] = v[i] * 17;
+            }
+        } else {
+            for(size_t i=0; i<len/2; i++) {
+                c[i] = v[2*i] * 16 + v[2*i+1];
+            }
+        }
+
+        *rgba = (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+        return true;
+    }
+
+    /*
+     * @fn parse_function
+     *
+     * @brief parse the arguments of rgb() or rgba()
+     *
+     * Components are separated by commas or whitespace; the optional alpha
+     * by a comma or a slash.
+     *
+     */
+    bool parse_function(const char* p, const char* end, uint32_t* rgba) {
+        unsigned int c[4] = {0, 0, 0, 255};
+        for(int i=0; i<4; i++) {
+            skip_spaces(p, end);
+            if(i == 3 && p != end && *p == ')') {
+                break;      // alpha is optional
+            }
+            if(i > 0 && p != end && (*p == ',' || (i == 3 && *p == '/'))) {
+                ++p;
+                skip_spaces(p, end);
+            }
+
+            double value;
+            bool percent;
+            if(!parse_number(p, end, &value, &percent)) {
+                return false;
+            }
+            if(i < 3) {
+                c[i] = to_byte(percent ? value * 255.0 / 100.0 : value);
+            } else {
+                c[i] = to_byte(255.0 * (percent ? value / 100.0 : value));
+            }
+        }
+
+        skip_spaces(p, end);
+        if(p == end || *p != ')') {
+            return false;
+        }
+        ++p;
+        skip_spaces(p, end);
+        if(p != end) {
+            return false;
+        }
+
+        *rgba = (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+        return true;
+    }
+}
+
 /**************************************************************************
  *                                                                        *
  *   Color Object                                                         *
  *                                                                        *
  **************************************************************************/
 
-/**
+Color::Color(const std::string& _spec) {
+    const char* begin = _spec.data();
+    const char* end = begin + _spec.size();
+
+    // legacy form: six hexadecimal digits without '#'
+    uint32_t value;
+    if(_spec.size() == 6 && parse_hex(begin, end, &value)) {
+        this->rgba = value;
+        return;
+    }
+
+    Color color;
+    if(!Color::parse(begin, end, &color)) {
+        std::cerr << _spec << std::endl;
+        throw std::runtime_error("Invalid color specification received.");
+    }
+    this->rgba = color.rgba;
+}
+
+/*
+ * @fn parse
  *
- * Color constructor
+ * @brief parse a CSS color specification without allocating
  *
+ * @param begin start of the specification
+ * @param end   end of the specification
+ * @param color receives the color
+ *
+ * @return whether the specification is valid
  */
-Color::Color() {
-  this->r = 0;
-  this->g = 0;
-  this->b = 0;
-}
+bool Color::parse(const char* begin, const char* end, Color* color) {
+    skip_spaces(begin, end);
+    while(end != begin && is_space(*(end - 1))) {
+        --end;
+    }
+    if(begin == end) {
+        return false;
+    }
 
-Color::Color(unsigned int _r, unsigned int _g, unsigned int _b) {
-    this->r = _r;
-    this->g = _g;
-    this->b = _b;
+    uint32_t value;
+    if(*begin == '#') {
+        if(!parse_hex(begin + 1, end, &value)) {
+            return false;
+        }
+        color->rgba = value;
+        return true;
+    }
 
-    this->hexcode = (boost::format("%X%X%X") % this->r % this->g % this->b).str();
-}
+    // functional notation
+    const char* paren = std::find(begin, end, '(');
+    if(paren != end) {
+        if((compare_name(begin, paren, "rgb") != 0 && compare_name(begin, paren, "rgba") != 0) ||
+           !parse_function(paren + 1, end, &value)) {
+            return false;
+        }
+        color->rgba = value;
+        return true;
+    }
 
-Color::Color(const std::string& _hex) {
-    this->hexcode = _hex;
-    this->r = this->hex2int(_hex.substr(0,2));
-    this->g = this->hex2int(_hex.substr(2,2));
-    this->b = this->hex2int(_hex.substr(4,2));
+    // named color
+    size_t lo = 0;
+    size_t hi = nr_named_colors;
+    while(lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const int cmp = compare_name(begin, end, named_colors[mid].name);
+        if(cmp == 0) {
+            color->rgba = named_colors[mid].rgba;
+            return true;
+        }
+        if(cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    return false;
 }
 
 /*
@@ -59,12 +482,12 @@ Color::Color(const std::string& _hex) {
  *
  * @return lightened color
  */
-Color Color::lighten(double _value) {
-    unsigned int nr = this->r * (1 - _value) + _value * 255.0f;
-    unsigned int ng = this->g * (1 - _value) + _value * 255.0f;
-    unsigned int nb = this->b * (1 - _value) + _value * 255.0f;
+Color Color::lighten(double _value) const {
+    unsigned int nr = this->get_r() * 255.0 * (1 - _value) + _value * 255.0f;
+    unsigned int ng = this->get_g() * 255.0 * (1 - _value) + _value * 255.0f;
+    unsigned int nb = this->get_b() * 255.0 * (1 - _value) + _value * 255.0f;
 
-    return Color(nr, ng, nb);
+    return Color(nr, ng, nb, this->rgba & 0xFF);
 }
 
 /*
@@ -76,28 +499,27 @@ Color Color::lighten(double _value) {
  *
  * @return darkened color
  */
-Color Color::darken(double _value) {
-    unsigned int nr = this->r * (1 - _value) + _value * 0.0f;
-    unsigned int ng = this->g * (1 - _value) + _value * 0.0f;
-    unsigned int nb = this->b * (1 - _value) + _value * 0.0f;
+Color Color::darken(double _value) const {
+    unsigned int nr = this->get_r() * 255.0 * (1 - _value) + _value * 0.0f;
+    unsigned int ng = this->get_g() * 255.0 * (1 - _value) + _value * 0.0f;
+    unsigned int nb = this->get_b() * 255.0 * (1 - _value) + _value * 0.0f;
 
-    return Color(nr, ng, nb);
+    return Color(nr, ng, nb, this->rgba & 0xFF);
 }
 
-/**
- * @fn hex2int
- *
- * @brief Convert a single hexadecimal value to an integer
+/*
+ * @fn get_color_code()
  *
- * @param _hex hexadecimal number in range 00-FF
+ * @brief return the hex color code
  *
- * @return unsigned integer in range 0-255
+ * @return hex color string (RRGGBB, or RRGGBBAA for translucent colors)
  */
-unsigned int Color::hex2int(const std::string &_hex) {
-    if(_hex.length() != 2) {
-        std::cerr << _hex << std::endl;
-        throw std::runtime_error("Invalid hex pattern received.");
-    }
-    char* offset;
-    return strtol(_hex.c_str(), &offset, 16);
-}
\ No newline at end of file
+std::string Color::get_color_code() const {
+    char buffer[9];
+    if(this->is_opaque()) {
+        std::snprintf(buffer, sizeof(buffer), "%06X", (unsigned int)(this->rgba >> 8));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%08X", (unsigned int)this->rgba);
+    }
+    return std::string(buffer);
+}
@@ -20,20 +20,89 @@
 #define _COLOR_H
 
 #include <iostream>
-#include <vector>
 #include <string>
 #include <stdexcept>
-#include <boost/format.hpp>
+#include <cstdint>
 
+/*
+ * @class Color
+ *
+ * @brief RGBA color packed into 32 bits (0xRRGGBBAA)
+ *
+ * Colors are trivially copyable and do not allocate; they can be parsed
+ * from any CSS color notation that can appear in a fill: #rgb, #rgba,
+ * #rrggbb, #rrggbbaa, rgb(), rgba() and the CSS named colors.
+ *
+ */
 class Color {
 private:
-    unsigned int r,g,b;     // 0-255 color values
-    std::string hexcode;
+    uint32_t rgba;      // packed 0-255 color values, red in the highest byte
 
 public:
-    Color();
-    Color(unsigned int _r, unsigned int _g, unsigned int _b);
-    Color(const std::string& _hex);
+    /**
+     * @fn Color
+     *
+     * @brief construct opaque black
+     */
+    constexpr Color() : rgba(0x000000FF) {}
+
+    /**
+     * @fn Color
+     *
+     * @brief construct a color from its components
+     *
+     * @param _r red in range 0-255
+     * @param _g green in range 0-255
+     * @param _b blue in range 0-255
+     * @param _a alpha in range 0-255
+     */
+    constexpr Color(unsigned int _r, unsigned int _g, unsigned int _b, unsigned int _a = 255) :
+        rgba(((_r & 0xFF) << 24) | ((_g & 0xFF) << 16) | ((_b & 0xFF) << 8) | (_a & 0xFF)) {}
+
+    /**
+     * @fn Color
+     *
+     * @brief construct a color from a CSS color specification
+     *
+     * For compatibility, six hexadecimal digits without leading '#' are
+     * accepted as well.
+     *
+     * @param _spec color specification
+     */
+    Color(const std::string& _spec);
+
+    /**
+     * @fn parse
+     *
+     * @brief parse a CSS color specification without allocating
+     *
+     * Surrounding whitespace is ignored.
+     *
+     * @param begin start of the specification
+     * @param end   end of the specification
+     * @param color receives the color
+     *
+     * @return whether the specification is valid
+     */
+    static bool parse(const char* begin, const char* end, Color* color);
+
+    /**
+     * @fn from_rgba
+     *
+     * @brief construct a color from its packed representation
+     */
+    static constexpr Color from_rgba(uint32_t _rgba) {
+        return Color((_rgba >> 24) & 0xFF, (_rgba >> 16) & 0xFF, (_rgba >> 8) & 0xFF, _rgba & 0xFF);
+    }
+
+    /**
+     * @fn get_rgba
+     *
+     * @brief Return the packed representation (0xRRGGBBAA)
+     */
+    inline constexpr uint32_t get_rgba() const {
+        return this->rgba;
+    }
 
     /**
      * @fn get_r
@@ -43,29 +112,62 @@ public:
      * @return float color value
      */
     inline float get_r() const {
-        return this->r / 255.0f;
+        return ((this->rgba >> 24) & 0xFF) / 255.0f;
     }
 
     /**
-     * @fn get_r
+     * @fn get_g
      *
      * @brief Return the float value for green in range [0-1]
      *
      * @return float color value
      */
     inline float get_g() const {
-        return this->g / 255.0f;
+        return ((this->rgba >> 16) & 0xFF) / 255.0f;
     }
 
     /**
-     * @fn get_r
+     * @fn get_b
      *
      * @brief Return the float value for blue in range [0-1]
      *
      * @return float color value
      */
     inline float get_b() const {
-        return this->b / 255.0f;
+        return ((this->rgba >> 8) & 0xFF) / 255.0f;
+    }
+
+    /**
+     * @fn get_a
+     *
+     * @brief Return the float value for alpha in range [0-1]
+     *
+     * @return float alpha value
+     */
+    inline float get_a() const {
+        return (this->rgba & 0xFF) / 255.0f;
+    }
+
+    /**
+     * @fn is_opaque
+     *
+     * @brief whether the color is fully opaque
+     */
+    inline constexpr bool is_opaque() const {
+        return (this->rgba & 0xFF) == 0xFF;
+    }
+
+    /*
+     * @fn with_opacity
+     *
+     * @brief multiply the alpha of the color by an opacity
+     *
+     * @param _opacity opacity 0-255
+     *
+     * @return color with reduced alpha
+     */
+    inline constexpr Color with_opacity(unsigned int _opacity) const {
+        return Color::from_rgba((this->rgba & 0xFFFFFF00) | (((this->rgba & 0xFF) * (_opacity & 0xFF) + 127) / 255));
     }
 
     /*
@@ -77,7 +179,7 @@ public:
      *
      * @return lightened color
      */
-    Color lighten(double _value);
+    Color lighten(double _value) const;
 
     /*
      * @fn darken
@@ -88,30 +190,24 @@ public:
      *
      * @return darkened color
      */
-    Color darken(double _value);
+    Color darken(double _value) const;
 
     /*
      * @fn get_color_code()
      *
      * @brief return the hex color code
      *
-     * @return hex color string
+     * @return hex color string (RRGGBB, or RRGGBBAA for translucent colors)
      */
-     inline const std::string& get_color_code() const {
-        return this->hexcode;
-     }
+    std::string get_color_code() const;
 
-private:
-    /**
-     * @fn hex2int
-     *
-     * @brief Convert a single hexadecimal value to an integer
-     *
-     * @param _hex hexadecimal number in range 00-FF
-     *
-     * @return unsigned integer in range 0-255
-     */
-    unsigned int hex2int(const std::string &_hex);
+    inline constexpr bool operator==(const Color& other) const {
+        return this->rgba == other.rgba;
+    }
+
+    inline constexpr bool operator!=(const Color& other) const {
+        return this->rgba != other.rgba;
+    }
 };
 
 #endif //_COLOR_H
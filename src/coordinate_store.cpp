@@ -0,0 +1,162 @@
+/************************************************************************************
+ *   coordinate_store.cpp  --  This file is part of LIBYASVG.                       *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "coordinate_store.h"
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    /*
+     * @fn quantize
+     *
+     * @brief store values as integer multiples of a step relative to an origin
+     *
+     */
+    template<typename T>
+    void quantize(T* out, const double* in, size_t n, const double* origin, const double* step) {
+        const double qmax = (double)std::numeric_limits<T>::max();
+        for(size_t i=0; i<n; i++) {
+            const int axis = i & 1;
+            const double q = step[axis] > 0.0 ? std::round((in[i] - origin[axis]) / step[axis]) : 0.0;
+            out[i] = (T)std::min(std::max(q, 0.0), qmax);
+        }
+    }
+
+    /*
+     * @fn dequantize
+     *
+     * @brief reconstruct values stored by quantize
+     *
+     */
+    template<typename T>
+    void dequantize(double* out, const T* in, size_t n, const double* origin, const double* step) {
+        for(size_t i=0; i<n; i++) {
+            const int axis = i & 1;
+            out[i] = origin[axis] + in[i] * step[axis];
+        }
+    }
+}
+
+/*****************************************************************
+ * COORDINATE STORE
+ *****************************************************************/
+
+Svg2Cairo::CoordinateStore::CoordinateStore(std::pmr::memory_resource* _resource, CoordinateStorage _format) :
+    resource(_resource), format(_format), values(nullptr), nr_values(0), origin{0.0, 0.0}, step{0.0, 0.0} {}
+
+Svg2Cairo::CoordinateStore::~CoordinateStore() {
+    this->release();
+}
+
+void Svg2Cairo::CoordinateStore::release() {
+    if(this->values != nullptr) {
+        this->resource->deallocate(this->values, this->nr_values * get_value_size(this->format), alignof(double));
+        this->values = nullptr;
+    }
+    this->nr_values = 0;
+}
+
+size_t Svg2Cairo::CoordinateStore::get_value_size(CoordinateStorage _format) {
+    switch(_format) {
+        case COORDINATES_FLOAT:
+            return sizeof(float);
+        case COORDINATES_INT32:
+            return sizeof(uint32_t);
+        case COORDINATES_INT16:
+            return sizeof(uint16_t);
+        default:
+            return sizeof(double);
+    }
+}
+
+void Svg2Cairo::CoordinateStore::assign(const double* _values, size_t n) {
+    this->release();
+    if(n == 0) {
+        return;
+    }
+
+    this->values = this->resource->allocate(n * get_value_size(this->format), alignof(double));
+    this->nr_values = n;
+
+    switch(this->format) {
+        case COORDINATES_DOUBLE:
+            std::copy(_values, _values + n, static_cast<double*>(this->values));
+        break;
+        case COORDINATES_FLOAT:
+            std::copy(_values, _values + n, static_cast<float*>(this->values));
+        break;
+        case COORDINATES_INT32:
+        case COORDINATES_INT16: {
+            // extent of the points in x and y
+            const BoundingBox box = point_bounds(_values, n / 2);
+            const double lo[2] = {box.x1, box.y1};
+            const double hi[2] = {box.x2, box.y2};
+
+            const double qmax = this->format == COORDINATES_INT32 ?
+                                (double)std::numeric_limits<uint32_t>::max() :
+                                (double)std::numeric_limits<uint16_t>::max();
+            for(int axis=0; axis<2; axis++) {
+                this->origin[axis] = lo[axis];
+                this->step[axis] = (hi[axis] - lo[axis]) / qmax;
+            }
+
+            if(this->format == COORDINATES_INT32) {
+                quantize(static_cast<uint32_t*>(this->values), _values, n, this->origin, this->step);
+            } else {
+                quantize(static_cast<uint16_t*>(this->values), _values, n, this->origin, this->step);
+            }
+        }
+        break;
+    }
+}
+
+const double* Svg2Cairo::CoordinateStore::expand(std::vector<double>& buffer) const {
+    if(this->format == COORDINATES_DOUBLE) {
+        return static_cast<const double*>(this->values);
+    }
+
+    buffer.resize(this->nr_values);
+    switch(this->format) {
+        case COORDINATES_FLOAT: {
+            const float* in = static_cast<const float*>(this->values);
+            std::copy(in, in + this->nr_values, buffer.begin());
+        }
+        break;
+        case COORDINATES_INT32:
+            dequantize(buffer.data(), static_cast<const uint32_t*>(this->values), this->nr_values, this->origin, this->step);
+        break;
+        case COORDINATES_INT16:
+            dequantize(buffer.data(), static_cast<const uint16_t*>(this->values), this->nr_values, this->origin, this->step);
+        break;
+        default:
+        break;
+    }
+    return buffer.data();
+}
@@ -0,0 +1,128 @@
+/************************************************************************************
+ *   coordinate_store.h  --  This file is part of LIBYASVG.                         *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _COORDINATE_STORE
+#define _COORDINATE_STORE
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+#include "load_options.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * COORDINATE STORE
+ *****************************************************************/
+
+/*
+ * @class CoordinateStore
+ *
+ * @brief list of (x,y) pairs kept in one of the CoordinateStorage formats
+ *
+ * The quantized formats map x and y separately onto the range spanned
+ * by the stored points, i.e. onto the bounding box of the shape's
+ * control points.
+ *
+ */
+class CoordinateStore {
+private:
+    std::pmr::memory_resource* resource;    //!< provides the storage
+    CoordinateStorage format;               //!< representation of the values
+    void* values;                           //!< packed values (nullptr when empty)
+    size_t nr_values;                       //!< number of values (twice the number of points)
+    double origin[2];                       //!< smallest x and y (quantized formats)
+    double step[2];                         //!< distance between quantization levels in x and y
+
+public:
+    /*
+     * @fn CoordinateStore
+     *
+     * @brief CoordinateStore constructor
+     *
+     * @param _resource memory resource providing the storage
+     * @param _format   representation of the values
+     *
+     */
+    CoordinateStore(std::pmr::memory_resource* _resource, CoordinateStorage _format);
+
+    ~CoordinateStore();
+
+    CoordinateStore(const CoordinateStore&) = delete;
+    CoordinateStore& operator=(const CoordinateStore&) = delete;
+
+    /*
+     * @fn assign
+     *
+     * @brief replace the contents by a list of points
+     *
+     * @param _values   x and y of every point
+     * @param n         number of values (even)
+     *
+     */
+    void assign(const double* _values, size_t n);
+
+    /*
+     * @fn expand
+     *
+     * @brief obtain the values as doubles
+     *
+     * @param buffer    receives the values unless they are stored as doubles
+     *
+     * @return pointer to the values (valid until buffer changes)
+     */
+    const double* expand(std::vector<double>& buffer) const;
+
+    inline size_t size() const {
+        return this->nr_values;
+    }
+
+    inline CoordinateStorage get_format() const {
+        return this->format;
+    }
+
+    /*
+     * @fn get_value_size
+     *
+     * @brief number of bytes of a single stored value
+     *
+     */
+    static size_t get_value_size(CoordinateStorage _format);
+
+private:
+    /*
+     * @fn release
+     *
+     * @brief return the storage to the memory resource
+     *
+     */
+    void release();
+};
+
+} // Svg2Cairo::
+
+#endif //_COORDINATE_STORE
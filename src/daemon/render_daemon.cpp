@@ -0,0 +1,767 @@
+/************************************************************************************
+ *   render_daemon.cpp  --  This file is part of LIBYASVG.                          *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "render_daemon.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    // longest request line
+    const size_t MAX_LINE = 4096;
+
+    /*
+     * @fn system_error
+     *
+     * @brief exception describing the failure of a system call
+     *
+     */
+    std::runtime_error system_error(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    /*
+     * @fn digest
+     *
+     * @brief digest of inline contents, keying them in the document cache
+     *
+     * Two 64 bit FNV-1a hashes (with different offsets and multipliers)
+     * and the length keep the key small whatever the size of the contents.
+     * The digest is not collision resistant, so an entry found by it is
+     * only used when its contents are equal as well.
+     *
+     */
+    std::string digest(const std::string& data) {
+        uint64_t h1 = 0xcbf29ce484222325ULL;
+        uint64_t h2 = 0x84222325cbf29ce4ULL;
+        for(const char c : data) {
+            h1 = (h1 ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+            h2 = (h2 ^ static_cast<unsigned char>(c)) * 0x9e3779b97f4a7c15ULL;
+        }
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%016llx%016llx:%zu", static_cast<unsigned long long>(h1),
+                 static_cast<unsigned long long>(h2), data.size());
+        return buffer;
+    }
+
+    /*
+     * @class Reader
+     *
+     * @brief buffered reading of lines and data from a socket
+     *
+     */
+    class Reader {
+    private:
+        int fd;                 //!< socket
+        std::string buffer;     //!< data read but not yet consumed
+
+    public:
+        Reader(int _fd) : fd(_fd) {}
+
+        // read a line without its end; false at the end of the stream
+        bool read_line(std::string& line) {
+            while(true) {
+                const size_t end = this->buffer.find('\n');
+                if(end != std::string::npos) {
+                    line.assign(this->buffer, 0, end);
+                    this->buffer.erase(0, end + 1);
+                    return true;
+                }
+                if(this->buffer.size() > MAX_LINE) {
+                    throw std::runtime_error("request line too long");
+                }
+                if(!this->fill()) {
+                    return false;
+                }
+            }
+        }
+
+        // read a number of bytes
+        void read_data(size_t length, std::string& data) {
+            while(this->buffer.size() < length) {
+                if(!this->fill()) {
+                    throw std::runtime_error("connection closed within the document");
+                }
+            }
+            data.assign(this->buffer, 0, length);
+            this->buffer.erase(0, length);
+        }
+
+    private:
+        bool fill() {
+            char block[65536];
+            ssize_t n;
+            do {
+                n = ::read(this->fd, block, sizeof(block));
+            } while(n < 0 && errno == EINTR);
+            if(n <= 0) {
+                return false;
+            }
+            this->buffer.append(block, static_cast<size_t>(n));
+            return true;
+        }
+    };
+
+    /*
+     * @class SharedMemory
+     *
+     * @brief anonymous shared memory mapped into this process
+     *
+     */
+    class SharedMemory {
+    public:
+        int fd = -1;                //!< descriptor passed to the client
+        void* data = MAP_FAILED;    //!< mapping
+        size_t size = 0;            //!< size in bytes
+
+        SharedMemory(size_t _size) : size(_size) {
+#ifdef __linux__
+            this->fd = memfd_create("svg2cairo", MFD_CLOEXEC);
+#else
+            // without memfd, a POSIX object that is unlinked right away
+            const std::string name = "/svg2cairo-" + std::to_string(getpid()) + "-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+            this->fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if(this->fd >= 0) {
+                shm_unlink(name.c_str());
+            }
+#endif
+            if(this->fd < 0) {
+                throw system_error("cannot create shared memory");
+            }
+            if(ftruncate(this->fd, static_cast<off_t>(this->size)) != 0) {
+                throw system_error("cannot size shared memory");
+            }
+            this->data = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+            if(this->data == MAP_FAILED) {
+                throw system_error("cannot map shared memory");
+            }
+        }
+
+        ~SharedMemory() {
+            if(this->data != MAP_FAILED) {
+                munmap(this->data, this->size);
+            }
+            if(this->fd >= 0) {
+                close(this->fd);
+            }
+        }
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+    };
+
+    /*
+     * @fn send_line
+     *
+     * @brief send a response line, optionally with a file descriptor attached
+     *
+     */
+    void send_line(int fd, const std::string& text, int attached = -1) {
+        std::string line = text + "\n";
+        size_t offset = 0;
+        while(offset < line.size()) {
+            struct iovec iov;
+            iov.iov_base = &line[offset];
+            iov.iov_len = line.size() - offset;
+
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+
+            // the descriptor travels with the first byte of the line
+            alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            if(attached >= 0 && offset == 0) {
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), &attached, sizeof(int));
+            }
+
+            const ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if(n < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                throw system_error("cannot send response");
+            }
+            offset += static_cast<size_t>(n);
+        }
+    }
+
+    /*
+     * @fn parse_request
+     *
+     * @brief split a request line into its command and key=value words
+     *
+     */
+    std::string parse_request(const std::string& line, std::unordered_map<std::string, std::string>& args) {
+        std::istringstream words(line);
+        std::string command;
+        words >> command;
+
+        std::string word;
+        while(words >> word) {
+            const size_t eq = word.find('=');
+            if(eq == std::string::npos) {
+                throw std::runtime_error("expected key=value instead of '" + word + "'");
+            }
+            const std::string key = word.substr(0, eq);
+            if(key == "path") {
+                // the path takes the remainder of the line, spaces included
+                std::string rest;
+                std::getline(words, rest);
+                args[key] = word.substr(eq + 1) + rest;
+                break;
+            }
+            args[key] = word.substr(eq + 1);
+        }
+        return command;
+    }
+
+    /*
+     * @fn get_number
+     *
+     * @brief get a finite numeric argument of a request
+     *
+     */
+    double get_number(const std::unordered_map<std::string, std::string>& args, const std::string& key, double fallback, bool required) {
+        auto it = args.find(key);
+        if(it == args.end()) {
+            if(required) {
+                throw std::runtime_error("missing " + key);
+            }
+            return fallback;
+        }
+        try {
+            size_t used = 0;
+            const double value = std::stod(it->second, &used);
+            if(used == it->second.size() && std::isfinite(value)) {
+                return value;
+            }
+        } catch(const std::exception&) {
+        }
+        throw std::runtime_error("invalid " + key + " '" + it->second + "'");
+    }
+
+    /*
+     * @fn single_line
+     *
+     * @brief make a message fit on a response line
+     *
+     */
+    std::string single_line(std::string message) {
+        std::replace(message.begin(), message.end(), '\n', ' ');
+        return message;
+    }
+}
+
+/*****************************************************************
+ * DOCUMENT CACHE
+ *****************************************************************/
+
+/*
+ * @fn get_file
+ *
+ * @brief get a document stored in a file, loading it when needed
+ *
+ * @param path          path of the file
+ * @param executor      executor doing the load
+ *
+ * @return document
+ */
+Svg2Cairo::DocumentCache::Document Svg2Cairo::DocumentCache::get_file(const std::string& path, Executor& executor) {
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) {
+        throw system_error("cannot open " + path);
+    }
+#ifdef __APPLE__
+    const long long mtime = st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    const long long mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+
+    return this->find_or_load("file:" + path, mtime, static_cast<long long>(st.st_size), std::string(), [&]() {
+        return executor.load_async(path).share();
+    });
+}
+
+/*
+ * @fn get_data
+ *
+ * @brief get a document from its contents, parsing it when needed
+ *
+ * @param data          contents of the document
+ * @param executor      executor doing the load
+ *
+ * @return document
+ */
+Svg2Cairo::DocumentCache::Document Svg2Cairo::DocumentCache::get_data(std::string data, Executor& executor) {
+    // hashed before locking the cache
+    const std::string key = "data:" + digest(data);
+    return this->find_or_load(key, 0, 0, data, [&]() {
+        return executor.load_buffer_async(data).share();
+    });
+}
+
+/*
+ * @fn get_stats
+ *
+ * @brief get the number of entries, hits and misses
+ *
+ */
+void Svg2Cairo::DocumentCache::get_stats(size_t* _entries, size_t* _hits, size_t* _misses) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    *_entries = this->entries.size();
+    *_hits = this->nr_hits;
+    *_misses = this->nr_misses;
+}
+
+Svg2Cairo::DocumentCache::Document Svg2Cairo::DocumentCache::find_or_load(const std::string& key, long long mtime, long long size,
+                                                                          const std::string& contents,
+                                                                          const std::function<Document()>& load) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    auto it = this->lookup.find(key);
+    if(it != this->lookup.end()) {
+        Entry& entry = *it->second;
+        // a key shared by different contents replaces the entry rather than serving another document
+        bool valid = entry.mtime == mtime && entry.size == size && entry.contents == contents;
+
+        // a failed load is not kept, such that a later request tries again
+        if(valid && entry.document.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                entry.document.get();
+            } catch(...) {
+                valid = false;
+            }
+        }
+
+        if(valid) {
+            this->entries.splice(this->entries.begin(), this->entries, it->second);
+            this->nr_hits++;
+            return entry.document;
+        }
+        this->entries.erase(it->second);
+        this->lookup.erase(it);
+    }
+
+    this->nr_misses++;
+    Document document = load();
+    this->entries.push_front(Entry{key, mtime, size, contents, std::move(document)});
+    this->lookup[key] = this->entries.begin();
+    while(this->entries.size() > this->capacity) {
+        this->lookup.erase(this->entries.back().key);
+        this->entries.pop_back();
+    }
+    return this->entries.front().document;
+}
+
+/*****************************************************************
+ * RENDER DAEMON
+ *****************************************************************/
+
+/*
+ * @fn RenderDaemon
+ *
+ * @brief create the socket and start listening
+ *
+ * An existing socket file at the path is replaced.
+ *
+ * @param _options  settings
+ *
+ */
+Svg2Cairo::RenderDaemon::RenderDaemon(const DaemonOptions& _options) :
+    options(_options),
+    cache(_options.cache_entries),
+    stopping(false),
+    executor(_options.executor) {
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(this->options.socket_path.empty() || this->options.socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("invalid socket path '" + this->options.socket_path + "'");
+    }
+    std::memcpy(addr.sun_path, this->options.socket_path.c_str(), this->options.socket_path.size());
+
+    if(pipe(this->wake_fds) != 0) {
+        throw system_error("cannot create pipe");
+    }
+    fcntl(this->wake_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(this->wake_fds[1], F_SETFD, FD_CLOEXEC);
+    fcntl(this->wake_fds[1], F_SETFL, O_NONBLOCK);
+
+    // the destructor does not run for a failing constructor
+    auto fail = [this](const std::string& what) {
+        const std::runtime_error error = system_error(what);
+        if(this->listen_fd >= 0) {
+            close(this->listen_fd);
+        }
+        close(this->wake_fds[0]);
+        close(this->wake_fds[1]);
+        return error;
+    };
+
+    this->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(this->listen_fd < 0) {
+        throw fail("cannot create socket");
+    }
+    fcntl(this->listen_fd, F_SETFD, FD_CLOEXEC);
+
+    unlink(this->options.socket_path.c_str());
+    if(bind(this->listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       listen(this->listen_fd, 64) != 0) {
+        throw fail("cannot listen on " + this->options.socket_path);
+    }
+}
+
+/*
+ * @fn ~RenderDaemon
+ *
+ * @brief stop listening and remove the socket file
+ *
+ */
+Svg2Cairo::RenderDaemon::~RenderDaemon() {
+    if(this->listen_fd >= 0) {
+        close(this->listen_fd);
+        unlink(this->options.socket_path.c_str());
+        this->listen_fd = -1;
+    }
+    for(int& fd : this->wake_fds) {
+        if(fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+/*
+ * @fn run
+ *
+ * @brief accept connections until stop is called
+ *
+ * Returns once all connections are closed.
+ *
+ */
+void Svg2Cairo::RenderDaemon::run() {
+    while(!this->stopping) {
+        struct pollfd fds[2];
+        fds[0].fd = this->listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = this->wake_fds[0];
+        fds[1].events = POLLIN;
+        if(poll(fds, 2, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw system_error("cannot wait for connections");
+        }
+        if(this->stopping || !(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        const int fd = accept(this->listen_fd, nullptr, nullptr);
+        if(fd < 0) {
+            continue;   // e.g. the client gave up before being accepted
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        std::unique_lock<std::mutex> lock(this->mtx);
+        if(this->connections.size() >= this->options.max_connections) {
+            lock.unlock();
+            try {
+                send_line(fd, "error message=too many connections");
+            } catch(const std::exception&) {
+            }
+            close(fd);
+            continue;
+        }
+        this->connections.insert(fd);
+        lock.unlock();
+
+        std::thread([this, fd]() {
+            this->serve(fd);
+
+            std::lock_guard<std::mutex> done(this->mtx);
+            this->connections.erase(fd);
+            close(fd);
+            this->cv_done.notify_all();
+        }).detach();
+    }
+
+    // wake the connections waiting for a request; requests in progress are completed
+    std::unique_lock<std::mutex> lock(this->mtx);
+    for(int fd : this->connections) {
+        shutdown(fd, SHUT_RD);
+    }
+    this->cv_done.wait(lock, [this]() { return this->connections.empty(); });
+}
+
+/*
+ * @fn stop
+ *
+ * @brief let run return (safe to call from a signal handler)
+ *
+ */
+void Svg2Cairo::RenderDaemon::stop() {
+    this->stopping = true;
+    const char wake = 1;
+    if(write(this->wake_fds[1], &wake, 1) < 0) {
+        // the pipe is full, so the loop is woken anyway
+    }
+}
+
+/*
+ * @fn serve
+ *
+ * @brief answer the requests of a single connection until it is closed
+ *
+ * @param fd    socket of the connection
+ *
+ */
+void Svg2Cairo::RenderDaemon::serve(int fd) {
+    Reader reader(fd);
+    std::string line;
+
+    while(true) {
+        std::unordered_map<std::string, std::string> args;
+        std::string command;
+        std::string data;
+
+        // a request that cannot be read leaves the stream in an unknown state, which ends the connection
+        try {
+            if(!reader.read_line(line)) {
+                return;
+            }
+            command = parse_request(line, args);
+
+            auto length = args.find("length");
+            if(length != args.end()) {
+                const double bytes = get_number(args, "length", 0.0, true);
+                if(!(bytes >= 0) || bytes != std::floor(bytes)) {
+                    throw std::runtime_error("invalid length");
+                }
+                if(bytes > static_cast<double>(this->options.max_inline_bytes)) {
+                    throw std::runtime_error("document too large");
+                }
+                reader.read_data(static_cast<size_t>(bytes), data);
+            }
+        } catch(const std::exception& e) {
+            this->record(false, -1.0);
+            try {
+                send_line(fd, "error message=" + single_line(e.what()));
+            } catch(const std::exception&) {
+            }
+            return;
+        }
+
+        try {
+            if(command == "render") {
+                this->render(fd, args, std::move(data));
+            } else if(command == "metrics") {
+                send_line(fd, this->get_metrics());
+                this->record(true, -1.0);
+            } else if(!command.empty()) {
+                throw std::runtime_error("unknown request '" + command + "'");
+            }
+        } catch(const std::exception& e) {
+            this->record(false, -1.0);
+            try {
+                send_line(fd, "error message=" + single_line(e.what()));
+            } catch(const std::exception&) {
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * @fn render
+ *
+ * @brief answer a render request
+ *
+ * @param fd        socket of the connection
+ * @param args      words of the request line by key
+ * @param data      document sent with the request (empty when a path is given)
+ *
+ */
+void Svg2Cairo::RenderDaemon::render(int fd, const std::unordered_map<std::string, std::string>& args, std::string data) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const double width = get_number(args, "width", 0.0, true);
+    const double height = get_number(args, "height", 0.0, true);
+    const double scale = get_number(args, "scale", 1.0, false);
+    // written such that NaN fails as well; the size is converted to int below
+    if(!(width >= 1 && height >= 1 && std::isfinite(width * height)) || width != std::floor(width) ||
+       height != std::floor(height) || width * height > static_cast<double>(this->options.max_pixels)) {
+        throw std::runtime_error("invalid size");
+    }
+    if(!(scale > 0.0)) {
+        throw std::runtime_error("invalid scale");
+    }
+
+    RenderOptions render_options;
+    auto quality = args.find("quality");
+    if(quality != args.end()) {
+        if(quality->second == "preview") {
+            render_options = RenderOptions::preview();
+        } else if(quality->second == "print") {
+            render_options = RenderOptions::print();
+        } else if(quality->second != "standard") {
+            throw std::runtime_error("invalid quality '" + quality->second + "'");
+        }
+    }
+
+    DocumentCache::Document document;
+    auto path = args.find("path");
+    if(path != args.end()) {
+        document = this->cache.get_file(path->second, this->executor);
+    } else if(args.count("length") != 0) {
+        document = this->cache.get_data(std::move(data), this->executor);
+    } else {
+        throw std::runtime_error("missing path or length");
+    }
+
+    struct Active {
+        RenderDaemon* daemon;
+        Active(RenderDaemon* _daemon) : daemon(_daemon) {
+            std::lock_guard<std::mutex> lock(this->daemon->mtx);
+            this->daemon->nr_active++;
+        }
+        ~Active() {
+            std::lock_guard<std::mutex> lock(this->daemon->mtx);
+            this->daemon->nr_active--;
+        }
+    } active(this);
+
+    // the pixels are drawn straight into the memory handed to the client
+    const int w = static_cast<int>(width);
+    const int h = static_cast<int>(height);
+    const int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w);
+    SharedMemory pixels(static_cast<size_t>(stride) * static_cast<size_t>(h));
+    {
+        std::shared_ptr<cairo_surface_t> surface(
+            cairo_image_surface_create_for_data(static_cast<unsigned char*>(pixels.data), CAIRO_FORMAT_ARGB32, w, h, stride),
+            cairo_surface_destroy);
+        cairo_surface_set_device_scale(surface.get(), scale, scale);
+        this->executor.render_async(document.get(), surface, render_options).get();
+    }
+
+    std::ostringstream response;
+    response << "ok width=" << w << " height=" << h << " stride=" << stride
+             << " format=argb32 bytes=" << pixels.size;
+    send_line(fd, response.str(), pixels.fd);
+
+    const std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - start;
+    this->record(true, latency.count());
+}
+
+/*
+ * @fn get_metrics
+ *
+ * @brief format the counters of the daemon
+ *
+ * @return response line
+ */
+std::string Svg2Cairo::RenderDaemon::get_metrics() {
+    size_t entries, hits, misses;
+    this->cache.get_stats(&entries, &hits, &misses);
+
+    std::vector<double> sorted;
+    size_t requests, errors, active, connected;
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        sorted = this->latencies;
+        requests = this->nr_requests;
+        errors = this->nr_errors;
+        active = this->nr_active;
+        connected = this->connections.size();
+    }
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    };
+
+    std::ostringstream out;
+    out << "ok requests=" << requests
+        << " errors=" << errors
+        << " connections=" << connected
+        << " active=" << active
+        << " queue_depth=" << this->executor.get_nr_pending()
+        << " cache_entries=" << entries
+        << " cache_hits=" << hits
+        << " cache_misses=" << misses
+        << " cache_hit_rate=" << (hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0)
+        << " latency_p50_ms=" << percentile(0.50)
+        << " latency_p90_ms=" << percentile(0.90)
+        << " latency_p99_ms=" << percentile(0.99);
+    return out.str();
+}
+
+/*
+ * @fn record
+ *
+ * @brief account for an answered request
+ *
+ * @param success   whether the request succeeded
+ * @param latency   time taken in ms (negative when not a render)
+ *
+ */
+void Svg2Cairo::RenderDaemon::record(bool success, double latency) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->nr_requests++;
+    if(!success) {
+        this->nr_errors++;
+    }
+    if(latency >= 0.0) {
+        if(this->latencies.size() < LATENCY_WINDOW) {
+            this->latencies.push_back(latency);
+        } else {
+            this->latencies[this->latency_pos] = latency;
+        }
+        this->latency_pos = (this->latency_pos + 1) % LATENCY_WINDOW;
+    }
+}
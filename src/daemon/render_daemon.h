@@ -0,0 +1,291 @@
+/************************************************************************************
+ *   render_daemon.h  --  This file is part of LIBYASVG.                            *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _RENDER_DAEMON
+#define _RENDER_DAEMON
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "executor.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * DAEMON OPTIONS
+ *****************************************************************/
+
+/*
+ * @class DaemonOptions
+ *
+ * @brief settings of a render daemon
+ *
+ */
+struct DaemonOptions {
+    std::string socket_path;                    //!< path of the Unix domain socket to listen on
+    size_t cache_entries = 64;                  //!< number of parsed documents kept
+    unsigned int max_connections = 64;          //!< connections served at the same time
+    size_t max_pixels = 8192 * 8192;            //!< largest image (width times height) rendered
+    size_t max_inline_bytes = 64 << 20;         //!< largest document sent with a request
+    ExecutorOptions executor;                   //!< threads and queues doing the loading and rendering
+};
+
+/*****************************************************************
+ * DOCUMENT CACHE
+ *****************************************************************/
+
+/*
+ * @class DocumentCache
+ *
+ * @brief parsed documents by file or content, least recently used first to go
+ *
+ * Entries hold the future of the load, such that concurrent requests for
+ * the same document share a single load. A file is loaded again when its
+ * modification time or size changed, and any document after a failed load.
+ * Inline documents are found by a digest of their contents, but only
+ * served when the contents kept with the entry are equal.
+ *
+ */
+class DocumentCache {
+public:
+    typedef std::shared_future<std::shared_ptr<Svg2Cairo> > Document;
+
+private:
+    /*
+     * @class Entry
+     *
+     * @brief cached document with the state of its file
+     *
+     */
+    struct Entry {
+        std::string key;        //!< "file:" followed by the path, or "data:" followed by a digest and the length of the contents
+        long long mtime;        //!< modification time of the file in nanoseconds (0 for contents)
+        long long size;         //!< size of the file in bytes (0 for contents)
+        std::string contents;   //!< contents of an inline document (empty for files)
+        Document document;      //!< (future) document
+    };
+
+    size_t capacity;                                                        //!< maximum number of entries
+    std::list<Entry> entries;                                               //!< most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> lookup;     //!< entries by key
+    std::mutex mtx;                                                         //!< guards the entries
+    size_t nr_hits = 0;                                                     //!< requests served from the cache
+    size_t nr_misses = 0;                                                   //!< requests that loaded a document
+
+public:
+    /*
+     * @fn DocumentCache
+     *
+     * @brief DocumentCache constructor
+     *
+     * @param _capacity     maximum number of documents
+     *
+     */
+    DocumentCache(size_t _capacity) : capacity(std::max<size_t>(_capacity, 1)) {}
+
+    /*
+     * @fn get_file
+     *
+     * @brief get a document stored in a file, loading it when needed
+     *
+     * @param path          path of the file
+     * @param executor      executor doing the load
+     *
+     * @return document
+     */
+    Document get_file(const std::string& path, Executor& executor);
+
+    /*
+     * @fn get_data
+     *
+     * @brief get a document from its contents, parsing it when needed
+     *
+     * @param data          contents of the document
+     * @param executor      executor doing the load
+     *
+     * @return document
+     */
+    Document get_data(std::string data, Executor& executor);
+
+    /*
+     * @fn get_stats
+     *
+     * @brief get the number of entries, hits and misses
+     *
+     */
+    void get_stats(size_t* _entries, size_t* _hits, size_t* _misses);
+
+private:
+    Document find_or_load(const std::string& key, long long mtime, long long size, const std::string& contents,
+                          const std::function<Document()>& load);
+};
+
+/*****************************************************************
+ * RENDER DAEMON
+ *****************************************************************/
+
+/*
+ * @class RenderDaemon
+ *
+ * @brief serves render requests over a Unix domain socket
+ *
+ * Every request and response starts with a single line of words; values
+ * are given as key=value. A path is always the last word and may contain
+ * spaces. Requests:
+ *
+ *   render width=W height=H [scale=S] [quality=preview|standard|print] path=FILE
+ *   render width=W height=H [scale=S] [quality=...] length=N      (followed by N bytes of SVG)
+ *   metrics
+ *
+ * A render is answered with "ok width=W height=H stride=S format=argb32
+ * bytes=B", with a file descriptor of shared memory holding the pixels
+ * attached to the message (SCM_RIGHTS). The client maps the memory and
+ * closes the descriptor; the pixels are never copied through the socket.
+ * Metrics are answered with "ok" followed by the counters. Failures are
+ * answered with "error message=...", after which the connection remains
+ * usable unless the request itself could not be read.
+ *
+ */
+class RenderDaemon {
+private:
+    DaemonOptions options;          //!< settings
+    DocumentCache cache;            //!< parsed documents
+    int listen_fd = -1;             //!< listening socket
+    int wake_fds[2] = {-1, -1};     //!< pipe interrupting the accept loop
+    std::atomic<bool> stopping;     //!< set once the daemon shuts down
+
+    std::mutex mtx;                             //!< guards the connections and the statistics
+    std::condition_variable cv_done;            //!< signals a finished connection
+    std::unordered_set<int> connections;        //!< sockets of the connections being served
+    size_t nr_requests = 0;                     //!< requests answered
+    size_t nr_errors = 0;                       //!< requests answered with an error
+    size_t nr_active = 0;                       //!< renders in progress
+    std::vector<double> latencies;              //!< most recent render latencies in ms (ring buffer)
+    size_t latency_pos = 0;                     //!< next slot of the ring buffer
+
+    static const size_t LATENCY_WINDOW = 4096;  //!< number of latencies kept for the percentiles
+
+    Executor executor;              //!< loads and renders (declared last, such that its jobs finish first)
+
+public:
+    /*
+     * @fn RenderDaemon
+     *
+     * @brief create the socket and start listening
+     *
+     * An existing socket file at the path is replaced.
+     *
+     * @param _options  settings
+     *
+     */
+    RenderDaemon(const DaemonOptions& _options);
+
+    /*
+     * @fn ~RenderDaemon
+     *
+     * @brief stop listening and remove the socket file
+     *
+     */
+    ~RenderDaemon();
+
+    RenderDaemon(const RenderDaemon&) = delete;
+    RenderDaemon& operator=(const RenderDaemon&) = delete;
+
+    /*
+     * @fn run
+     *
+     * @brief accept connections until stop is called
+     *
+     * Returns once all connections are closed.
+     *
+     */
+    void run();
+
+    /*
+     * @fn stop
+     *
+     * @brief let run return (safe to call from a signal handler)
+     *
+     */
+    void stop();
+
+private:
+    /*
+     * @fn serve
+     *
+     * @brief answer the requests of a single connection until it is closed
+     *
+     * @param fd    socket of the connection
+     *
+     */
+    void serve(int fd);
+
+    /*
+     * @fn render
+     *
+     * @brief answer a render request
+     *
+     * @param fd        socket of the connection
+     * @param args      words of the request line by key
+     * @param data      document sent with the request (empty when a path is given)
+     *
+     */
+    void render(int fd, const std::unordered_map<std::string, std::string>& args, std::string data);
+
+    /*
+     * @fn get_metrics
+     *
+     * @brief format the counters of the daemon
+     *
+     * @return response line
+     */
+    std::string get_metrics();
+
+    /*
+     * @fn record
+     *
+     * @brief account for an answered request
+     *
+     * @param success   whether the request succeeded
+     * @param latency   time taken in ms (negative when not a render)
+     *
+     */
+    void record(bool success, double latency);
+};
+
+} // Svg2Cairo::
+
+#endif //_RENDER_DAEMON
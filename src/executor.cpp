@@ -0,0 +1,194 @@
+/************************************************************************************
+ *   executor.cpp  --  This file is part of LIBYASVG.                               *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "executor.h"
+
+#include <fstream>
+#include <sstream>
+#include <iterator>
+
+namespace {
+    /*
+     * @fn read_file
+     *
+     * @brief read a complete file into memory
+     *
+     * @param filename  path of the file
+     *
+     * @return contents of the file
+     */
+    std::string read_file(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if(!in) {
+            // same error as reading the file through the XML parser
+            throw boost::property_tree::xml_parser_error("cannot open file", filename, 0);
+        }
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    /*
+     * @fn parse
+     *
+     * @brief construct a document from SVG data
+     *
+     */
+    std::shared_ptr<Svg2Cairo::Svg2Cairo> parse(const std::string& data, const Svg2Cairo::LoadOptions& options,
+                                                const Svg2Cairo::CancellationToken& token) {
+        if(token.is_cancelled()) {
+            throw Svg2Cairo::CancelledError();
+        }
+        std::istringstream stream(data);
+        auto doc = std::make_shared<Svg2Cairo::Svg2Cairo>(stream, options);
+        if(token.is_cancelled()) {
+            throw Svg2Cairo::CancelledError();
+        }
+        return doc;
+    }
+
+    /*
+     * @fn render
+     *
+     * @brief draw a document onto a surface, reporting a cancelled draw
+     *
+     */
+    void render(const Svg2Cairo::Svg2Cairo& doc, cairo_surface_t* surface, const Svg2Cairo::RenderOptions& options,
+                const Svg2Cairo::CancellationToken& token) {
+        auto cr = cairo_create(surface);
+        const bool complete = doc.draw(cr, options, token);
+        cairo_destroy(cr);
+        if(!complete) {
+            throw Svg2Cairo::CancelledError();
+        }
+        cairo_surface_flush(surface);
+    }
+}
+
+/*****************************************************************
+ * EXECUTOR
+ *****************************************************************/
+
+Svg2Cairo::Executor::Executor(const ExecutorOptions& options) :
+    wait_when_full(options.wait_when_full),
+    cpu_pool(options.cpu_threads, options.max_queued_cpu),
+    io_pool(options.io_threads, options.max_queued_io) {}
+
+std::future<std::shared_ptr<Svg2Cairo::Svg2Cairo> > Svg2Cairo::Executor::load_async(const std::string& filename,
+                                                                                   const LoadOptions& options,
+                                                                                   const CancellationToken& token) {
+    // the request spans two pools, so its result is delivered through a promise
+    typedef std::shared_ptr<Svg2Cairo> Document;
+    auto promise = std::make_shared<std::promise<Document> >();
+    std::future<Document> result = promise->get_future();
+
+    std::future<void> read = this->schedule(this->io_pool, [this, filename, options, token, promise]() {
+        try {
+            if(token.is_cancelled()) {
+                throw CancelledError();
+            }
+            std::string data = read_file(filename);
+
+            // always wait for room: a full CPU queue should slow down the reads rather than fail them
+            this->cpu_pool.submit([data = std::move(data), options, token, promise]() {
+                try {
+                    promise->set_value(parse(data, options, token));
+                } catch(...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        } catch(...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+
+    // a refused read never runs; forward its error
+    if(read.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        try {
+            read.get();
+        } catch(const QueueFullError&) {
+            promise->set_exception(std::current_exception());
+        }
+    }
+
+    return result;
+}
+
+std::future<std::shared_ptr<Svg2Cairo::Svg2Cairo> > Svg2Cairo::Executor::load_buffer_async(std::string data,
+                                                                                          const LoadOptions& options,
+                                                                                          const CancellationToken& token) {
+    return this->schedule(this->cpu_pool, [data = std::move(data), options, token]() {
+        return parse(data, options, token);
+    });
+}
+
+std::future<std::shared_ptr<cairo_surface_t> > Svg2Cairo::Executor::render_async(std::shared_ptr<const Svg2Cairo> doc,
+                                                                                 int width, int height,
+                                                                                 const RenderOptions& options,
+                                                                                 const CancellationToken& token) {
+    return this->schedule(this->cpu_pool, [doc = std::move(doc), width, height, options, token]() {
+        if(token.is_cancelled()) {
+            throw CancelledError();
+        }
+
+        std::shared_ptr<cairo_surface_t> surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height),
+                                                 cairo_surface_destroy);
+        if(cairo_surface_status(surface.get()) != CAIRO_STATUS_SUCCESS) {
+            throw std::runtime_error("Could not create a surface of " + std::to_string(width) + "x" + std::to_string(height) + " pixels");
+        }
+
+        render(*doc, surface.get(), options, token);
+        return surface;
+    });
+}
+
+std::future<std::shared_ptr<cairo_surface_t> > Svg2Cairo::Executor::render_async(std::shared_ptr<const Svg2Cairo> doc,
+                                                                                 std::shared_ptr<cairo_surface_t> surface,
+                                                                                 const RenderOptions& options,
+                                                                                 const CancellationToken& token) {
+    return this->schedule(this->cpu_pool, [doc = std::move(doc), surface = std::move(surface), options, token]() {
+        if(token.is_cancelled()) {
+            throw CancelledError();
+        }
+
+        render(*doc, surface.get(), options, token);
+        return surface;
+    });
+}
+
+template<typename F>
+auto Svg2Cairo::Executor::schedule(WorkerPool& pool, F&& f) -> std::future<decltype(f())> {
+    typedef decltype(f()) R;
+    if(this->wait_when_full) {
+        return pool.submit(std::forward<F>(f));
+    }
+
+    auto result = pool.try_submit(std::forward<F>(f));
+    if(!result) {
+        std::promise<R> refused;
+        refused.set_exception(std::make_exception_ptr(QueueFullError()));
+        return refused.get_future();
+    }
+    return std::move(*result);
+}
@@ -0,0 +1,216 @@
+/************************************************************************************
+ *   executor.h  --  This file is part of LIBYASVG.                                 *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _EXECUTOR
+#define _EXECUTOR
+
+#include <cairo.h>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "svg2cairo.h"
+#include "worker_pool.h"
+#include "cancellation.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * EXECUTOR
+ *****************************************************************/
+
+/*
+ * @class ExecutorOptions
+ *
+ * @brief sizes of the thread pools and request queues of an Executor
+ *
+ */
+struct ExecutorOptions {
+    unsigned int io_threads = 2;        //!< threads reading files
+    unsigned int cpu_threads = 0;       //!< threads parsing and rendering documents (0: hardware concurrency)
+    size_t max_queued_io = 64;          //!< file reads that may wait for a thread
+    size_t max_queued_cpu = 64;         //!< parse and render jobs that may wait for a thread
+    bool wait_when_full = false;        //!< let callers wait for room in a full queue instead of refusing the request
+};
+
+/*
+ * @class QueueFullError
+ *
+ * @brief reported by a request that was refused because its queue was full
+ *
+ */
+class QueueFullError : public std::runtime_error {
+public:
+    QueueFullError() : std::runtime_error("request queue full") {}
+};
+
+/*
+ * @class Executor
+ *
+ * @brief runs load and render requests in the background
+ *
+ * Every request returns a future immediately. Files are read on a
+ * separate pool, such that slow storage does not occupy the threads
+ * doing the parsing and rendering. Both queues are bounded: a request
+ * arriving at a full queue is refused (its future holds a QueueFullError)
+ * unless the executor was configured to wait. A read that finishes while
+ * the CPU queue is full waits for room, which in turn holds back the
+ * remaining reads.
+ *
+ * A request whose token is cancelled before it completes reports a
+ * CancelledError. Loading checks the token between its stages, rendering
+ * before every shape.
+ *
+ */
+class Executor {
+private:
+    bool wait_when_full;    //!< whether callers wait for room in a full queue
+    WorkerPool cpu_pool;    //!< parses and renders (declared first, such that it outlives the reads feeding it)
+    WorkerPool io_pool;     //!< reads files
+
+public:
+    /*
+     * @fn Executor
+     *
+     * @brief Executor constructor
+     *
+     * @param options   sizes of the thread pools and queues
+     *
+     */
+    Executor(const ExecutorOptions& options = ExecutorOptions());
+
+    /*
+     * @fn ~Executor
+     *
+     * @brief finish all accepted requests and stop the threads
+     *
+     */
+    ~Executor() = default;
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /*
+     * @fn load_async
+     *
+     * @brief load a document from a file
+     *
+     * The number of threads in the load options applies to each document;
+     * with several concurrent requests the default of one is appropriate.
+     *
+     * @param filename  path of the SVG file
+     * @param options   loading settings
+     * @param token     cancellation token
+     *
+     * @return future holding the document
+     */
+    std::future<std::shared_ptr<Svg2Cairo> > load_async(const std::string& filename,
+                                                        const LoadOptions& options = LoadOptions(),
+                                                        const CancellationToken& token = CancellationToken());
+
+    /*
+     * @fn load_buffer_async
+     *
+     * @brief load a document from SVG data held in memory
+     *
+     * @param data      contents of the SVG file
+     * @param options   loading settings
+     * @param token     cancellation token
+     *
+     * @return future holding the document
+     */
+    std::future<std::shared_ptr<Svg2Cairo> > load_buffer_async(std::string data,
+                                                               const LoadOptions& options = LoadOptions(),
+                                                               const CancellationToken& token = CancellationToken());
+
+    /*
+     * @fn render_async
+     *
+     * @brief draw a document onto a new transparent ARGB32 image surface
+     *
+     * @param doc       document (kept alive until the render finishes)
+     * @param width     width of the surface in pixels
+     * @param height    height of the surface in pixels
+     * @param options   accuracy settings
+     * @param token     cancellation token
+     *
+     * @return future holding the surface (destroyed with the last reference)
+     */
+    std::future<std::shared_ptr<cairo_surface_t> > render_async(std::shared_ptr<const Svg2Cairo> doc,
+                                                                int width, int height,
+                                                                const RenderOptions& options = RenderOptions(),
+                                                                const CancellationToken& token = CancellationToken());
+
+    /*
+     * @fn render_async
+     *
+     * @brief draw a document onto an existing surface
+     *
+     * Allows rendering into memory owned by the caller, e.g. an image
+     * surface created for shared memory. The surface is not cleared.
+     *
+     * @param doc       document (kept alive until the render finishes)
+     * @param surface   surface to draw onto (kept alive until the render finishes)
+     * @param options   accuracy settings
+     * @param token     cancellation token
+     *
+     * @return future holding the surface
+     */
+    std::future<std::shared_ptr<cairo_surface_t> > render_async(std::shared_ptr<const Svg2Cairo> doc,
+                                                                std::shared_ptr<cairo_surface_t> surface,
+                                                                const RenderOptions& options = RenderOptions(),
+                                                                const CancellationToken& token = CancellationToken());
+
+    /*
+     * @fn get_nr_pending
+     *
+     * @brief get the number of requests waiting for a thread
+     *
+     * @return number of pending file reads and parse/render jobs
+     */
+    inline size_t get_nr_pending() {
+        return this->io_pool.get_nr_pending() + this->cpu_pool.get_nr_pending();
+    }
+
+private:
+    /*
+     * @fn schedule
+     *
+     * @brief submit a task, honouring the queue policy
+     *
+     * @param pool      pool running the task
+     * @param f         callable without arguments
+     *
+     * @return future of the task (holding a QueueFullError if it was refused)
+     */
+    template<typename F>
+    auto schedule(WorkerPool& pool, F&& f) -> std::future<decltype(f())>;
+};
+
+} // Svg2Cairo::
+
+#endif //_EXECUTOR
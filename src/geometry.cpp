@@ -0,0 +1,223 @@
+/************************************************************************************
+ *   geometry.cpp  --  This file is part of LIBYASVG.                               *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "geometry.h"
+#include "kernels.h"
+
+#include <cmath>
+
+/*
+ * @fn transform_bounds
+ *
+ * @brief calculate the bounding box of a transformed bounding box
+ *
+ * @param m     transformation matrix
+ * @param box   bounding box
+ *
+ * @return bounding box enclosing the four transformed corners
+ */
+Svg2Cairo::BoundingBox Svg2Cairo::transform_bounds(const cairo_matrix_t& m, const BoundingBox& box) {
+    BoundingBox result;
+    if(box.empty()) {
+        return result;
+    }
+
+    const double xs[4] = {box.x1, box.x2, box.x1, box.x2};
+    const double ys[4] = {box.y1, box.y1, box.y2, box.y2};
+    for(unsigned int i=0; i<4; i++) {
+        result.add(m.xx * xs[i] + m.xy * ys[i] + m.x0,
+                   m.yx * xs[i] + m.yy * ys[i] + m.y0);
+    }
+
+    return result;
+}
+
+/*
+ * @fn max_scale
+ *
+ * @brief calculate the largest scaling factor of a transformation
+ *
+ * @param m     transformation matrix
+ *
+ * @return scaling factor
+ */
+double Svg2Cairo::max_scale(const cairo_matrix_t& m) {
+    const double s = m.xx * m.xx + m.xy * m.xy + m.yx * m.yx + m.yy * m.yy;
+    const double det = m.xx * m.yy - m.xy * m.yx;
+    const double disc = std::max(0.0, s * s - 4.0 * det * det);
+    return std::sqrt(0.5 * (s + std::sqrt(disc)));
+}
+
+/*
+ * @fn device_scale
+ *
+ * @brief calculate the largest device scale of the target of a cairo object
+ *
+ * @param cr    pointer to cairo object
+ *
+ * @return pixels per device unit
+ */
+double Svg2Cairo::device_scale(cairo_t* cr) {
+    double sx = 1.0, sy = 1.0;
+    cairo_surface_get_device_scale(cairo_get_target(cr), &sx, &sy);
+    return std::max(std::fabs(sx), std::fabs(sy));
+}
+
+/*
+ * @fn flatten_curve
+ *
+ * @brief approximate a cubic Bezier curve by line segments
+ *
+ * The curve is split into segments of equal parameter length; the number
+ * of segments follows from the bound on the second derivative of the curve.
+ *
+ */
+void Svg2Cairo::flatten_curve(std::vector<double>& pts,
+                              double x0, double y0, double x1, double y1,
+                              double x2, double y2, double x3, double y3,
+                              double tolerance) {
+    // maximum deviation of a chord is bounded by 3/4 * max|P[i] - 2P[i+1] + P[i+2]| / n^2
+    const double ddx = std::max(std::fabs(x0 - 2.0 * x1 + x2), std::fabs(x1 - 2.0 * x2 + x3));
+    const double ddy = std::max(std::fabs(y0 - 2.0 * y1 + y2), std::fabs(y1 - 2.0 * y2 + y3));
+    const double dd = std::sqrt(ddx * ddx + ddy * ddy);
+    const unsigned int n = std::min(1024u, std::max(1u, (unsigned int)std::ceil(std::sqrt(0.75 * dd / tolerance))));
+
+    // the inner points are evaluated in bulk
+    const double ctrl[8] = {x0, y0, x1, y1, x2, y2, x3, y3};
+    const size_t offset = pts.size();
+    pts.resize(offset + 2 * (n - 1));
+    evaluate_cubic(ctrl, n, pts.data() + offset);
+    pts.push_back(x3);
+    pts.push_back(y3);
+}
+
+/*
+ * @fn flatten_arc
+ *
+ * @brief approximate an elliptical arc (drawn in negative direction) by line segments
+ *
+ */
+void Svg2Cairo::flatten_arc(std::vector<double>& pts,
+                            double cx, double cy, double phi, double rx, double ry,
+                            double angle1, double angle2, double tolerance) {
+    // same normalization of the end angle as cairo_arc_negative
+    if(angle2 > angle1) {
+        angle2 = std::fmod(angle2 - angle1, 2.0 * M_PI);
+        if(angle2 > 0) {
+            angle2 -= 2.0 * M_PI;
+        }
+        angle2 += angle1;
+    }
+
+    // the chord of an angle step d deviates at most r (1 - cos(d/2)) from the arc
+    const double r = std::max(std::fabs(rx), std::fabs(ry));
+    double step = M_PI / 2.0;
+    if(r > tolerance) {
+        step = std::min(step, 2.0 * std::acos(1.0 - tolerance / r));
+    }
+    const unsigned int n = std::min(4096u, std::max(1u, (unsigned int)std::ceil((angle1 - angle2) / step)));
+
+    const double cos_phi = std::cos(phi);
+    const double sin_phi = std::sin(phi);
+    for(unsigned int i=0; i<=n; i++) {
+        const double a = angle1 + (angle2 - angle1) * (double)i / (double)n;
+        const double ex = rx * std::cos(a);
+        const double ey = ry * std::sin(a);
+        pts.push_back(cx + cos_phi * ex - sin_phi * ey);
+        pts.push_back(cy + sin_phi * ex + cos_phi * ey);
+    }
+}
+
+/*
+ * @fn simplify_polyline
+ *
+ * @brief remove vertices of a polyline that deviate less than the tolerance (Douglas-Peucker)
+ *
+ * @param pts       (x,y) pairs of the polyline
+ * @param n         number of points
+ * @param tolerance maximum deviation of the simplified polyline
+ * @param out       vector receiving the retained (x,y) pairs
+ *
+ */
+void Svg2Cairo::simplify_polyline(const double* pts, size_t n, double tolerance, std::vector<double>& out) {
+    if(n <= 2) {
+        out.insert(out.end(), pts, pts + 2 * n);
+        return;
+    }
+
+    std::vector<bool> keep(n, false);
+    keep[0] = keep[n-1] = true;
+
+    // iterative version of the algorithm, using an explicit stack of ranges
+    std::vector<std::pair<size_t, size_t> > stack;
+    stack.emplace_back(0, n-1);
+    const double tol2 = tolerance * tolerance;
+
+    while(!stack.empty()) {
+        const size_t first = stack.back().first;
+        const size_t last = stack.back().second;
+        stack.pop_back();
+
+        const double ax = pts[2*first];
+        const double ay = pts[2*first+1];
+        const double dx = pts[2*last] - ax;
+        const double dy = pts[2*last+1] - ay;
+        const double len2 = dx * dx + dy * dy;
+
+        double dmax = 0.0;
+        size_t imax = first;
+        for(size_t i=first+1; i<last; i++) {
+            const double px = pts[2*i] - ax;
+            const double py = pts[2*i+1] - ay;
+            double d2;
+            if(len2 > 0.0) {
+                const double t = std::min(1.0, std::max(0.0, (px * dx + py * dy) / len2));
+                const double qx = px - t * dx;
+                const double qy = py - t * dy;
+                d2 = qx * qx + qy * qy;
+            } else {
+                d2 = px * px + py * py;
+            }
+            if(d2 > dmax) {
+                dmax = d2;
+                imax = i;
+            }
+        }
+
+        if(dmax > tol2) {
+            keep[imax] = true;
+            stack.emplace_back(first, imax);
+            stack.emplace_back(imax, last);
+        }
+    }
+
+    for(size_t i=0; i<n; i++) {
+        if(keep[i]) {
+            out.push_back(pts[2*i]);
+            out.push_back(pts[2*i+1]);
+        }
+    }
+}
@@ -0,0 +1,181 @@
+/************************************************************************************
+ *   geometry.h  --  This file is part of LIBYASVG.                                 *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _GEOMETRY
+#define _GEOMETRY
+
+#include <cairo.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * BOUNDING BOX
+ *****************************************************************/
+
+/*
+ * @class BoundingBox
+ *
+ * @brief axis-aligned bounding box
+ *
+ */
+struct BoundingBox {
+    double x1 = std::numeric_limits<double>::infinity();    //!< lower x
+    double y1 = std::numeric_limits<double>::infinity();    //!< lower y
+    double x2 = -std::numeric_limits<double>::infinity();   //!< upper x
+    double y2 = -std::numeric_limits<double>::infinity();   //!< upper y
+
+    inline void add(double x, double y) {
+        this->x1 = std::min(this->x1, x);
+        this->y1 = std::min(this->y1, y);
+        this->x2 = std::max(this->x2, x);
+        this->y2 = std::max(this->y2, y);
+    }
+
+    inline void add(const BoundingBox& box) {
+        this->x1 = std::min(this->x1, box.x1);
+        this->y1 = std::min(this->y1, box.y1);
+        this->x2 = std::max(this->x2, box.x2);
+        this->y2 = std::max(this->y2, box.y2);
+    }
+
+    inline bool empty() const {
+        return this->x1 > this->x2 || this->y1 > this->y2;
+    }
+
+    inline double width() const {
+        return this->empty() ? 0.0 : this->x2 - this->x1;
+    }
+
+    inline double height() const {
+        return this->empty() ? 0.0 : this->y2 - this->y1;
+    }
+};
+
+/*****************************************************************
+ * GEOMETRY ROUTINES
+ *****************************************************************/
+
+/*
+ * @fn transform_bounds
+ *
+ * @brief calculate the bounding box of a transformed bounding box
+ *
+ * @param m     transformation matrix
+ * @param box   bounding box
+ *
+ * @return bounding box enclosing the four transformed corners
+ */
+BoundingBox transform_bounds(const cairo_matrix_t& m, const BoundingBox& box);
+
+/*
+ * @fn max_scale
+ *
+ * @brief calculate the largest scaling factor of a transformation
+ *
+ * This is the largest singular value of the linear part of the matrix,
+ * i.e. no distance grows by more than this factor under the transform.
+ *
+ * @param m     transformation matrix
+ *
+ * @return scaling factor
+ */
+double max_scale(const cairo_matrix_t& m);
+
+/*
+ * @fn device_scale
+ *
+ * @brief calculate the largest device scale of the target of a cairo object
+ *
+ * The device scale (cairo_surface_set_device_scale) is not part of the
+ * matrix of cr; it converts the device units of that matrix to pixels.
+ *
+ * @param cr    pointer to cairo object
+ *
+ * @return pixels per device unit
+ */
+double device_scale(cairo_t* cr);
+
+/*
+ * @fn flatten_curve
+ *
+ * @brief approximate a cubic Bezier curve by line segments
+ *
+ * The start point is not written; the end point always is.
+ *
+ * @param pts       vector receiving the (x,y) pairs
+ * @param x0,y0     start point
+ * @param x1,y1     first control point
+ * @param x2,y2     second control point
+ * @param x3,y3     end point
+ * @param tolerance maximum deviation from the curve
+ *
+ */
+void flatten_curve(std::vector<double>& pts,
+                   double x0, double y0, double x1, double y1,
+                   double x2, double y2, double x3, double y3,
+                   double tolerance);
+
+/*
+ * @fn flatten_arc
+ *
+ * @brief approximate an elliptical arc (drawn in negative direction) by line segments
+ *
+ * The ellipse is positioned as cairo_arc_negative of a unit circle
+ * under translate(cx,cy), rotate(phi) and scale(rx,ry). Both the start
+ * and the end point are written.
+ *
+ * @param pts       vector receiving the (x,y) pairs
+ * @param cx,cy     center
+ * @param phi       rotation of the ellipse
+ * @param rx,ry     radii
+ * @param angle1    start angle
+ * @param angle2    end angle
+ * @param tolerance maximum deviation from the arc
+ *
+ */
+void flatten_arc(std::vector<double>& pts,
+                 double cx, double cy, double phi, double rx, double ry,
+                 double angle1, double angle2, double tolerance);
+
+/*
+ * @fn simplify_polyline
+ *
+ * @brief remove vertices of a polyline that deviate less than the tolerance (Douglas-Peucker)
+ *
+ * @param pts       (x,y) pairs of the polyline
+ * @param n         number of points
+ * @param tolerance maximum deviation of the simplified polyline
+ * @param out       vector receiving the retained (x,y) pairs
+ *
+ */
+void simplify_polyline(const double* pts, size_t n, double tolerance, std::vector<double>& out);
+
+} // Svg2Cairo::
+
+#endif //_GEOMETRY
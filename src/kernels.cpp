@@ -0,0 +1,372 @@
+/************************************************************************************
+ *   kernels.cpp  --  This file is part of LIBYASVG.                                *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    using Svg2Cairo::BoundingBox;
+
+    /*
+     * @class KernelTable
+     *
+     * @brief the kernels of one instruction set
+     *
+     */
+    struct KernelTable {
+        void (*transform_points)(const cairo_matrix_t&, const double*, double*, size_t);
+        BoundingBox (*point_bounds)(const double*, size_t);
+        void (*evaluate_cubic)(const double*, unsigned int, double*);
+    };
+
+    /*****************************************************************
+     * SCALAR
+     *****************************************************************/
+
+    void transform_points_scalar(const cairo_matrix_t& m, const double* in, double* out, size_t n) {
+        for(size_t i=0; i<n; i++) {
+            const double x = in[2*i];
+            const double y = in[2*i+1];
+            out[2*i] = m.xx * x + m.xy * y + m.x0;
+            out[2*i+1] = m.yx * x + m.yy * y + m.y0;
+        }
+    }
+
+    BoundingBox point_bounds_scalar(const double* pts, size_t n) {
+        BoundingBox box;
+        for(size_t i=0; i<n; i++) {
+            box.add(pts[2*i], pts[2*i+1]);
+        }
+        return box;
+    }
+
+    void evaluate_cubic_scalar(const double* c, unsigned int n, double* out) {
+        for(unsigned int i=1; i<n; i++) {
+            const double t = (double)i / (double)n;
+            const double u = 1.0 - t;
+            const double b0 = u * u * u;
+            const double b1 = 3.0 * u * u * t;
+            const double b2 = 3.0 * u * t * t;
+            const double b3 = t * t * t;
+            *out++ = b0 * c[0] + b1 * c[2] + b2 * c[4] + b3 * c[6];
+            *out++ = b0 * c[1] + b1 * c[3] + b2 * c[5] + b3 * c[7];
+        }
+    }
+
+    const KernelTable scalar_kernels = {
+        transform_points_scalar, point_bounds_scalar, evaluate_cubic_scalar
+    };
+
+#ifdef _KERNELS_X86
+    /*
+     * The vector kernels evaluate every expression in the same order as
+     * the scalar ones and do not use fused multiply-add, such that their
+     * results are bitwise identical. Minima and maxima take the new value
+     * as first operand, which (as std::min and std::max) ignores NaN.
+     */
+
+    /*****************************************************************
+     * SSE2
+     *****************************************************************/
+
+    __attribute__((target("sse2")))
+    void transform_points_sse2(const cairo_matrix_t& m, const double* in, double* out, size_t n) {
+        const __m128d a = _mm_set_pd(m.yx, m.xx);
+        const __m128d b = _mm_set_pd(m.yy, m.xy);
+        const __m128d t = _mm_set_pd(m.y0, m.x0);
+        for(size_t i=0; i<n; i++) {
+            const __m128d p = _mm_loadu_pd(in + 2*i);
+            const __m128d x = _mm_unpacklo_pd(p, p);
+            const __m128d y = _mm_unpackhi_pd(p, p);
+            _mm_storeu_pd(out + 2*i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, x), _mm_mul_pd(b, y)), t));
+        }
+    }
+
+    __attribute__((target("sse2")))
+    BoundingBox point_bounds_sse2(const double* pts, size_t n) {
+        // two independent accumulators hide the latency of min and max
+        __m128d lo0 = _mm_set1_pd(std::numeric_limits<double>::infinity());
+        __m128d hi0 = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+        __m128d lo1 = lo0;
+        __m128d hi1 = hi0;
+        size_t i = 0;
+        for(; i+2<=n; i+=2) {
+            const __m128d p0 = _mm_loadu_pd(pts + 2*i);
+            const __m128d p1 = _mm_loadu_pd(pts + 2*i + 2);
+            lo0 = _mm_min_pd(p0, lo0);
+            hi0 = _mm_max_pd(p0, hi0);
+            lo1 = _mm_min_pd(p1, lo1);
+            hi1 = _mm_max_pd(p1, hi1);
+        }
+        if(i < n) {
+            const __m128d p = _mm_loadu_pd(pts + 2*i);
+            lo0 = _mm_min_pd(p, lo0);
+            hi0 = _mm_max_pd(p, hi0);
+        }
+
+        double lo[2], hi[2];
+        _mm_storeu_pd(lo, _mm_min_pd(lo1, lo0));
+        _mm_storeu_pd(hi, _mm_max_pd(hi1, hi0));
+        BoundingBox box;
+        box.x1 = lo[0];
+        box.y1 = lo[1];
+        box.x2 = hi[0];
+        box.y2 = hi[1];
+        return box;
+    }
+
+    __attribute__((target("sse2")))
+    void evaluate_cubic_sse2(const double* c, unsigned int n, double* out) {
+        const __m128d p0 = _mm_loadu_pd(c);
+        const __m128d p1 = _mm_loadu_pd(c + 2);
+        const __m128d p2 = _mm_loadu_pd(c + 4);
+        const __m128d p3 = _mm_loadu_pd(c + 6);
+        for(unsigned int i=1; i<n; i++) {
+            const double t = (double)i / (double)n;
+            const double u = 1.0 - t;
+            const __m128d b0 = _mm_set1_pd(u * u * u);
+            const __m128d b1 = _mm_set1_pd(3.0 * u * u * t);
+            const __m128d b2 = _mm_set1_pd(3.0 * u * t * t);
+            const __m128d b3 = _mm_set1_pd(t * t * t);
+            __m128d r = _mm_add_pd(_mm_mul_pd(b0, p0), _mm_mul_pd(b1, p1));
+            r = _mm_add_pd(r, _mm_mul_pd(b2, p2));
+            r = _mm_add_pd(r, _mm_mul_pd(b3, p3));
+            _mm_storeu_pd(out, r);
+            out += 2;
+        }
+    }
+
+    const KernelTable sse2_kernels = {
+        transform_points_sse2, point_bounds_sse2, evaluate_cubic_sse2
+    };
+
+    /*****************************************************************
+     * AVX2
+     *****************************************************************/
+
+    __attribute__((target("avx2")))
+    void transform_points_avx2(const cairo_matrix_t& m, const double* in, double* out, size_t n) {
+        const __m256d a = _mm256_set_pd(m.yx, m.xx, m.yx, m.xx);
+        const __m256d b = _mm256_set_pd(m.yy, m.xy, m.yy, m.xy);
+        const __m256d t = _mm256_set_pd(m.y0, m.x0, m.y0, m.x0);
+        size_t i = 0;
+        for(; i+4<=n; i+=4) {
+            const __m256d p0 = _mm256_loadu_pd(in + 2*i);
+            const __m256d p1 = _mm256_loadu_pd(in + 2*i + 4);
+            const __m256d x0 = _mm256_permute_pd(p0, 0x0);
+            const __m256d y0 = _mm256_permute_pd(p0, 0xF);
+            const __m256d x1 = _mm256_permute_pd(p1, 0x0);
+            const __m256d y1 = _mm256_permute_pd(p1, 0xF);
+            _mm256_storeu_pd(out + 2*i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, x0), _mm256_mul_pd(b, y0)), t));
+            _mm256_storeu_pd(out + 2*i + 4, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, x1), _mm256_mul_pd(b, y1)), t));
+        }
+        for(; i<n; i++) {
+            const double x = in[2*i];
+            const double y = in[2*i+1];
+            out[2*i] = m.xx * x + m.xy * y + m.x0;
+            out[2*i+1] = m.yx * x + m.yy * y + m.y0;
+        }
+    }
+
+    __attribute__((target("avx2")))
+    BoundingBox point_bounds_avx2(const double* pts, size_t n) {
+        // every register holds two points
+        __m256d lo0 = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        __m256d hi0 = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        __m256d lo1 = lo0;
+        __m256d hi1 = hi0;
+        size_t i = 0;
+        for(; i+4<=n; i+=4) {
+            const __m256d p0 = _mm256_loadu_pd(pts + 2*i);
+            const __m256d p1 = _mm256_loadu_pd(pts + 2*i + 4);
+            lo0 = _mm256_min_pd(p0, lo0);
+            hi0 = _mm256_max_pd(p0, hi0);
+            lo1 = _mm256_min_pd(p1, lo1);
+            hi1 = _mm256_max_pd(p1, hi1);
+        }
+        lo0 = _mm256_min_pd(lo1, lo0);
+        hi0 = _mm256_max_pd(hi1, hi0);
+
+        // fold the upper and lower halves and add the remaining points
+        double lo[4], hi[4];
+        _mm256_storeu_pd(lo, lo0);
+        _mm256_storeu_pd(hi, hi0);
+        BoundingBox box;
+        box.x1 = std::min(lo[2], lo[0]);
+        box.y1 = std::min(lo[3], lo[1]);
+        box.x2 = std::max(hi[2], hi[0]);
+        box.y2 = std::max(hi[3], hi[1]);
+        for(; i<n; i++) {
+            box.add(pts[2*i], pts[2*i+1]);
+        }
+        return box;
+    }
+
+    __attribute__((target("avx2")))
+    void evaluate_cubic_avx2(const double* c, unsigned int n, double* out) {
+        const __m128d q0 = _mm_loadu_pd(c);
+        const __m128d q1 = _mm_loadu_pd(c + 2);
+        const __m128d q2 = _mm_loadu_pd(c + 4);
+        const __m128d q3 = _mm_loadu_pd(c + 6);
+        const __m256d p0 = _mm256_set_m128d(q0, q0);
+        const __m256d p1 = _mm256_set_m128d(q1, q1);
+        const __m256d p2 = _mm256_set_m128d(q2, q2);
+        const __m256d p3 = _mm256_set_m128d(q3, q3);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d three = _mm256_set1_pd(3.0);
+        const __m256d segments = _mm256_set1_pd((double)n);
+
+        // two parameters per register: (t_i, t_i, t_i+1, t_i+1)
+        unsigned int i = 1;
+        for(; i+2<=n; i+=2) {
+            const __m256d t = _mm256_div_pd(_mm256_set_pd(i+1, i+1, i, i), segments);
+            const __m256d u = _mm256_sub_pd(one, t);
+            const __m256d b0 = _mm256_mul_pd(_mm256_mul_pd(u, u), u);
+            const __m256d b1 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(three, u), u), t);
+            const __m256d b2 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(three, u), t), t);
+            const __m256d b3 = _mm256_mul_pd(_mm256_mul_pd(t, t), t);
+            __m256d r = _mm256_add_pd(_mm256_mul_pd(b0, p0), _mm256_mul_pd(b1, p1));
+            r = _mm256_add_pd(r, _mm256_mul_pd(b2, p2));
+            r = _mm256_add_pd(r, _mm256_mul_pd(b3, p3));
+            _mm256_storeu_pd(out, r);
+            out += 4;
+        }
+        if(i < n) {
+            const double t = (double)i / (double)n;
+            const double u = 1.0 - t;
+            const double b0 = u * u * u;
+            const double b1 = 3.0 * u * u * t;
+            const double b2 = 3.0 * u * t * t;
+            const double b3 = t * t * t;
+            out[0] = b0 * c[0] + b1 * c[2] + b2 * c[4] + b3 * c[6];
+            out[1] = b0 * c[1] + b1 * c[3] + b2 * c[5] + b3 * c[7];
+        }
+    }
+
+    const KernelTable avx2_kernels = {
+        transform_points_avx2, point_bounds_avx2, evaluate_cubic_avx2
+    };
+#endif // _KERNELS_X86
+
+    /*****************************************************************
+     * DISPATCH
+     *****************************************************************/
+
+    const KernelTable* get_table(Svg2Cairo::KernelSet set) {
+        switch(set) {
+#ifdef _KERNELS_X86
+            case Svg2Cairo::KERNELS_AVX2:
+                return &avx2_kernels;
+            case Svg2Cairo::KERNELS_SSE2:
+                return &sse2_kernels;
+#endif
+            default:
+                return &scalar_kernels;
+        }
+    }
+
+    /*
+     * @fn active_table
+     *
+     * @brief kernels in use (initialized to the best supported set on first use)
+     *
+     */
+    std::atomic<const KernelTable*>& active_table() {
+        static std::atomic<const KernelTable*> table(get_table(Svg2Cairo::get_best_kernel_set()));
+        return table;
+    }
+}
+
+Svg2Cairo::KernelSet Svg2Cairo::get_best_kernel_set() {
+#ifdef _KERNELS_X86
+    static const KernelSet best = []() {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2")) {
+            return KERNELS_AVX2;
+        }
+        if(__builtin_cpu_supports("sse2")) {
+            return KERNELS_SSE2;
+        }
+        return KERNELS_SCALAR;
+    }();
+    return best;
+#else
+    return KERNELS_SCALAR;
+#endif
+}
+
+Svg2Cairo::KernelSet Svg2Cairo::get_kernel_set() {
+    const KernelTable* table = active_table().load(std::memory_order_relaxed);
+#ifdef _KERNELS_X86
+    if(table == &avx2_kernels) {
+        return KERNELS_AVX2;
+    }
+    if(table == &sse2_kernels) {
+        return KERNELS_SSE2;
+    }
+#endif
+    (void)table;
+    return KERNELS_SCALAR;
+}
+
+Svg2Cairo::KernelSet Svg2Cairo::set_kernel_set(KernelSet set) {
+    if(set > get_best_kernel_set()) {
+        set = get_best_kernel_set();
+    }
+    active_table().store(get_table(set), std::memory_order_relaxed);
+    return set;
+}
+
+const char* Svg2Cairo::get_kernel_name(KernelSet set) {
+    switch(set) {
+        case KERNELS_AVX2:
+            return "avx2";
+        case KERNELS_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+void Svg2Cairo::transform_points(const cairo_matrix_t& m, const double* in, double* out, size_t n) {
+    active_table().load(std::memory_order_relaxed)->transform_points(m, in, out, n);
+}
+
+Svg2Cairo::BoundingBox Svg2Cairo::point_bounds(const double* pts, size_t n) {
+    return active_table().load(std::memory_order_relaxed)->point_bounds(pts, n);
+}
+
+void Svg2Cairo::evaluate_cubic(const double* ctrl, unsigned int n, double* out) {
+    active_table().load(std::memory_order_relaxed)->evaluate_cubic(ctrl, n, out);
+}
@@ -0,0 +1,139 @@
+/************************************************************************************
+ *   kernels.h  --  This file is part of LIBYASVG.                                  *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _KERNELS
+#define _KERNELS
+
+#include <cairo.h>
+#include <cstddef>
+
+#include "geometry.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * KERNEL SELECTION
+ *****************************************************************/
+
+/*
+ * @enum KernelSet
+ *
+ * @brief instruction set used by the bulk geometry kernels
+ *
+ * The best set supported by the processor is selected when a kernel is
+ * first called. All sets produce bitwise identical results.
+ *
+ */
+enum KernelSet {
+    KERNELS_SCALAR,     //!< portable C++
+    KERNELS_SSE2,       //!< 128-bit vectors (one point per register)
+    KERNELS_AVX2        //!< 256-bit vectors (two points per register)
+};
+
+/*
+ * @fn get_kernel_set
+ *
+ * @brief instruction set currently used by the kernels
+ *
+ */
+KernelSet get_kernel_set();
+
+/*
+ * @fn get_best_kernel_set
+ *
+ * @brief best instruction set supported by the processor
+ *
+ */
+KernelSet get_best_kernel_set();
+
+/*
+ * @fn set_kernel_set
+ *
+ * @brief select the instruction set of the kernels (e.g. for benchmarking)
+ *
+ * Sets the processor does not support are replaced by the best supported one.
+ *
+ * @param set       requested instruction set
+ *
+ * @return instruction set that is used
+ */
+KernelSet set_kernel_set(KernelSet set);
+
+/*
+ * @fn get_kernel_name
+ *
+ * @brief printable name of an instruction set
+ *
+ */
+const char* get_kernel_name(KernelSet set);
+
+/*****************************************************************
+ * KERNELS
+ *****************************************************************/
+
+/*
+ * @fn transform_points
+ *
+ * @brief apply an affine transformation to an array of (x,y) pairs
+ *
+ * @param m     transformation matrix
+ * @param in    (x,y) pairs
+ * @param out   transformed (x,y) pairs (may be the same array as in)
+ * @param n     number of points
+ *
+ */
+void transform_points(const cairo_matrix_t& m, const double* in, double* out, size_t n);
+
+/*
+ * @fn point_bounds
+ *
+ * @brief calculate the bounding box of an array of (x,y) pairs
+ *
+ * @param pts   (x,y) pairs
+ * @param n     number of points
+ *
+ * @return bounding box (empty when n is zero)
+ */
+BoundingBox point_bounds(const double* pts, size_t n);
+
+/*
+ * @fn evaluate_cubic
+ *
+ * @brief evaluate a cubic Bezier curve at equidistant parameters
+ *
+ * The curve is evaluated at t = i/n for i = 1 .. n-1, i.e. the inner
+ * points of a subdivision into n segments.
+ *
+ * @param ctrl  start point, control points and end point (8 values)
+ * @param n     number of segments
+ * @param out   array receiving n-1 (x,y) pairs
+ *
+ */
+void evaluate_cubic(const double* ctrl, unsigned int n, double* out);
+
+} // Svg2Cairo::
+
+#endif //_KERNELS
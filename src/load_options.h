@@ -0,0 +1,106 @@
+/************************************************************************************
+ *   load_options.h  --  This file is part of LIBYASVG.                             *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _LOAD_OPTIONS
+#define _LOAD_OPTIONS
+
+#include <memory_resource>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * LOAD OPTIONS
+ *****************************************************************/
+
+/*
+ * @enum CoordinateStorage
+ *
+ * @brief representation of the compiled coordinates of a shape
+ *
+ * The quantized formats store every coordinate as an integer fraction
+ * of the extent of the shape's coordinates, i.e. the error is at most
+ * half the extent divided by 2^bits - 1.
+ *
+ */
+enum CoordinateStorage {
+    COORDINATES_DOUBLE,     //!< 8 bytes per value, exact
+    COORDINATES_FLOAT,      //!< 4 bytes per value, 24 bit mantissa
+    COORDINATES_INT32,      //!< 4 bytes per value, quantized relative to the extent
+    COORDINATES_INT16       //!< 2 bytes per value, quantized relative to the extent
+};
+
+/*
+ * @class LoadOptions
+ *
+ * @brief settings controlling how a document is loaded
+ *
+ */
+struct LoadOptions {
+    /*
+     * Number of threads converting the attributes (path data, style and
+     * transform) of the elements. The XML is always read sequentially;
+     * the conversions are independent per element and are distributed
+     * over a worker pool when more than one thread is used.
+     * 0 uses the hardware concurrency.
+     */
+    unsigned int nr_threads = 1;
+
+    /*
+     * Postpone compiling the path data until a path is first drawn. Only
+     * the bounding box is determined while loading, which keeps loading
+     * fast and memory low for large documents of which only a part is
+     * ever rendered. The XML tree is retained and serves as the source.
+     */
+    bool lazy = false;
+
+    /*
+     * All shapes and their data are allocated from an arena owned by the
+     * document, which obtains its memory in a few large blocks from this
+     * resource and returns them when the document is destroyed.
+     * nullptr uses new/delete.
+     */
+    std::pmr::memory_resource* upstream = nullptr;
+
+    /*
+     * Storage of the compiled coordinates of paths and circles. The
+     * compact formats trade precision for memory; for documents that are
+     * rendered at their nominal size COORDINATES_INT16 is usually below
+     * the visible threshold. Svg2Cairo::get_bytes_used reports the
+     * resulting memory footprint.
+     */
+    CoordinateStorage coordinates = COORDINATES_DOUBLE;
+
+    /*
+     * Create a cairo pattern for every distinct paint in the document
+     * while loading, which drawing then selects as source instead of
+     * constructing a new solid pattern for every shape.
+     */
+    bool cache_paint = true;
+};
+
+} // Svg2Cairo::
+
+#endif //_LOAD_OPTIONS
@@ -26,7 +26,74 @@
 
 #include "svg2cairo.h"
 
-int main() {
+#ifdef _DAEMON
+#include "daemon/render_daemon.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    Svg2Cairo::RenderDaemon* daemon_instance = nullptr;    //!< daemon stopped by SIGINT and SIGTERM
+
+    void handle_signal(int) {
+        if(daemon_instance != nullptr) {
+            daemon_instance->stop();
+        }
+    }
+
+    /*
+     * @fn run_daemon
+     *
+     * @brief serve render requests on a Unix domain socket until interrupted
+     *
+     * usage: svg2cairo --daemon SOCKET [--cache N] [--threads N] [--connections N]
+     *
+     */
+    int run_daemon(int argc, char* argv[]) {
+        Svg2Cairo::DaemonOptions options;
+        options.socket_path = argv[2];
+        for(int i=3; i + 1 < argc; i += 2) {
+            const unsigned long value = std::strtoul(argv[i + 1], nullptr, 10);
+            if(std::strcmp(argv[i], "--cache") == 0) {
+                options.cache_entries = value;
+            } else if(std::strcmp(argv[i], "--threads") == 0) {
+                options.executor.cpu_threads = value;
+            } else if(std::strcmp(argv[i], "--connections") == 0) {
+                options.max_connections = value;
+            } else {
+                std::cerr << "Unknown option " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+
+        try {
+            Svg2Cairo::RenderDaemon daemon(options);
+            daemon_instance = &daemon;
+            std::signal(SIGINT, handle_signal);
+            std::signal(SIGTERM, handle_signal);
+            daemon.run();
+            daemon_instance = nullptr;
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+#ifdef _DAEMON
+    if(argc > 2 && std::strcmp(argv[1], "--daemon") == 0) {
+        return run_daemon(argc, argv);
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+
     // load mkmcxx logo into Cairo
     Svg2Cairo::Svg2Cairo svg_writer("../example.svg");
 
@@ -0,0 +1,82 @@
+/************************************************************************************
+ *   progressive.cpp  --  This file is part of LIBYASVG.                            *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "progressive.h"
+
+/*
+ * @fn reset
+ *
+ * @brief start over at the next draw call
+ *
+ */
+void Svg2Cairo::DrawCursor::reset() {
+    this->document = nullptr;
+    this->pending.clear();
+    this->items.clear();
+    this->order.clear();
+    this->pass = PASS_COLLECT;
+    this->position = 0;
+    this->layer.reset();
+}
+
+/*
+ * @fn get_progress
+ *
+ * @brief get the fraction of the work done over both passes
+ *
+ * @return value between 0 and 1
+ */
+double Svg2Cairo::DrawCursor::get_progress() const {
+    if(this->pass == PASS_DONE) {
+        return this->document != nullptr ? 1.0 : 0.0;
+    }
+    if(this->pass == PASS_COLLECT || this->items.empty()) {
+        return 0.0;
+    }
+
+    const size_t done = (this->pass == PASS_REFINE ? this->items.size() : 0) + this->position;
+    return static_cast<double>(done) / static_cast<double>(2 * this->items.size());
+}
+
+/*
+ * @fn matches
+ *
+ * @brief whether the cursor continues a draw of a document onto a canvas
+ *
+ * @param _document     document to draw
+ * @param _matrix       current transformation of the canvas
+ * @param _clip         current clip region in device space
+ *
+ * @return true when the cursor can be resumed
+ */
+bool Svg2Cairo::DrawCursor::matches(const Svg2Cairo* _document, const cairo_matrix_t& _matrix, const BoundingBox& _clip) const {
+    return this->document == _document &&
+           this->matrix.xx == _matrix.xx && this->matrix.yx == _matrix.yx &&
+           this->matrix.xy == _matrix.xy && this->matrix.yy == _matrix.yy &&
+           this->matrix.x0 == _matrix.x0 && this->matrix.y0 == _matrix.y0 &&
+           this->clip.x1 == _clip.x1 && this->clip.y1 == _clip.y1 &&
+           this->clip.x2 == _clip.x2 && this->clip.y2 == _clip.y2;
+}
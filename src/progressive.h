@@ -0,0 +1,194 @@
+/************************************************************************************
+ *   progressive.h  --  This file is part of LIBYASVG.                              *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _PROGRESSIVE
+#define _PROGRESSIVE
+
+#include <cairo.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "color.h"
+#include "geometry.h"
+
+namespace Svg2Cairo {
+
+class Shape;
+class Svg2Cairo;
+
+/*****************************************************************
+ * DRAW CURSOR
+ *****************************************************************/
+
+/*
+ * @class DrawCursor
+ *
+ * @brief progress of a document drawn over several time-bounded calls
+ *
+ * The visible shapes are gathered first, which for large documents may
+ * take several calls by itself. The first pass draws the shapes in order
+ * of decreasing on-screen area with the preview settings, such that a
+ * budget that runs out early still leaves the most prominent shapes on
+ * the canvas. The second pass draws
+ * all shapes in document order with the requested settings onto a copy of
+ * the canvas as it was before the first pass; the copy replaces the
+ * preview once it is complete, so the final image equals that of a
+ * regular draw. When no copy can be made (e.g. for a very large or
+ * unbounded canvas), the preview is skipped and the second pass draws
+ * onto the canvas directly.
+ *
+ * The cursor belongs to a single document and canvas. It starts over when
+ * it is used with another document, transformation or clip region, and
+ * after a call to reset.
+ *
+ */
+class DrawCursor {
+public:
+    enum Pass {
+        PASS_COLLECT,       //!< the visible shapes are gathered
+        PASS_PREVIEW,       //!< shapes are drawn by decreasing area at preview quality
+        PASS_REFINE,        //!< shapes are drawn in document order at full quality
+        PASS_DONE           //!< the canvas holds the final image
+    };
+
+private:
+    /*
+     * @class Item
+     *
+     * @brief single shape with its resolved transformation and fill
+     *
+     */
+    struct Item {
+        const Shape* shape;         //!< shape to fill (never a group or instance)
+        cairo_matrix_t matrix;      //!< user to device transformation of the shape
+        Color fill;                 //!< fill color including the inherited opacity
+        BoundingBox box;            //!< bounds in device space
+    };
+
+    /*
+     * @class Frame
+     *
+     * @brief group or instance of which the shapes are being gathered
+     *
+     */
+    struct Frame {
+        const Shape* shape;         //!< group, or instance of a single shape
+        size_t next;                //!< next child to visit
+        cairo_matrix_t matrix;      //!< user to device transformation of the children
+        Color paint;                //!< fill color inherited by the children
+        unsigned int opacity;       //!< fill opacity inherited by the children
+    };
+
+    const Svg2Cairo* document = nullptr;    //!< document the items belong to
+    cairo_matrix_t matrix;                  //!< transformation of the canvas when started
+    BoundingBox clip;                       //!< clip region in device space when started
+    std::vector<Frame> pending;             //!< groups and instances still being gathered
+    std::vector<Item> items;                //!< visible shapes in document order
+    std::vector<uint32_t> order;            //!< items by decreasing area (a heap while previewing)
+    Pass pass = PASS_COLLECT;               //!< current pass
+    size_t position = 0;                    //!< next item of the current pass
+
+    std::shared_ptr<cairo_surface_t> layer; //!< canvas copy receiving the refined image (nullptr: no preview, draw on the canvas)
+    int x0 = 0;                             //!< device x of the first column of the layer
+    int y0 = 0;                             //!< device y of the first row of the layer
+
+public:
+    /*
+     * @fn reset
+     *
+     * @brief start over at the next draw call
+     *
+     */
+    void reset();
+
+    /*
+     * @fn get_pass
+     *
+     * @brief get the current pass
+     *
+     * @return pass
+     */
+    inline Pass get_pass() const {
+        return this->pass;
+    }
+
+    /*
+     * @fn is_complete
+     *
+     * @brief whether the canvas holds the final image
+     *
+     * @return true when both passes have finished
+     */
+    inline bool is_complete() const {
+        return this->document != nullptr && this->pass == PASS_DONE;
+    }
+
+    /*
+     * @fn get_progress
+     *
+     * @brief get the fraction of the work done over both passes
+     *
+     * @return value between 0 and 1
+     */
+    double get_progress() const;
+
+private:
+    /*
+     * @fn matches
+     *
+     * @brief whether the cursor continues a draw of a document onto a canvas
+     *
+     * @param _document     document to draw
+     * @param _matrix       current transformation of the canvas
+     * @param _clip         current clip region in device space
+     *
+     * @return true when the cursor can be resumed
+     */
+    bool matches(const Svg2Cairo* _document, const cairo_matrix_t& _matrix, const BoundingBox& _clip) const;
+
+    /*
+     * @fn previewed_after
+     *
+     * @brief order of the preview pass: by decreasing area, then in document order
+     *
+     * @param a     index of an item
+     * @param b     index of another item
+     *
+     * @return whether item a is drawn after item b
+     */
+    inline bool previewed_after(uint32_t a, uint32_t b) const {
+        const double area_a = this->items[a].box.width() * this->items[a].box.height();
+        const double area_b = this->items[b].box.width() * this->items[b].box.height();
+        return area_a < area_b || (area_a == area_b && a > b);
+    }
+
+    friend class Svg2Cairo;
+};
+
+} // Svg2Cairo::
+
+#endif //_PROGRESSIVE
@@ -0,0 +1,103 @@
+/************************************************************************************
+ *   render_options.h  --  This file is part of LIBYASVG.                           *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _RENDER_OPTIONS
+#define _RENDER_OPTIONS
+
+#include <cairo.h>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * RENDER OPTIONS
+ *****************************************************************/
+
+/*
+ * @class RenderOptions
+ *
+ * @brief settings controlling the trade-off between accuracy and speed of a render
+ *
+ * A default-constructed object renders with cairo's default antialiasing
+ * and tolerance. The named presets can be used as a starting point and
+ * adjusted field by field.
+ *
+ */
+struct RenderOptions {
+    cairo_antialias_t antialias = CAIRO_ANTIALIAS_DEFAULT;  //!< antialiasing mode of the fill operations
+    double tolerance = 0.1;         //!< tolerance of cairo's curve flattening in device pixels
+    double lod_tolerance = 0.0;     //!< maximum deviation of simplified paths and flattened arcs in device pixels (0: exact)
+    double cull_size = 0.0;         //!< shapes smaller than this size in device pixels are skipped (0: draw all)
+    double sprite_radius = 0.0;     //!< circles on image surfaces with a smaller radius in device pixels are composited from cached sprites (0: never)
+
+    /*
+     * @fn preview
+     *
+     * @brief fast render for thumbnails and previews
+     *
+     * @return render options
+     */
+    static inline RenderOptions preview() {
+        RenderOptions options;
+        options.antialias = CAIRO_ANTIALIAS_FAST;
+        options.tolerance = 0.5;
+        options.lod_tolerance = 0.5;
+        options.cull_size = 0.5;
+        options.sprite_radius = 16.0;
+        return options;
+    }
+
+    /*
+     * @fn standard
+     *
+     * @brief balanced render (equal to a default-constructed object)
+     *
+     * @return render options
+     */
+    static inline RenderOptions standard() {
+        return RenderOptions();
+    }
+
+    /*
+     * @fn print
+     *
+     * @brief most accurate render, without any simplification
+     *
+     * @return render options
+     */
+    static inline RenderOptions print() {
+        RenderOptions options;
+        options.antialias = CAIRO_ANTIALIAS_BEST;
+        options.tolerance = 0.01;
+        options.lod_tolerance = 0.0;
+        options.cull_size = 0.0;
+        options.sprite_radius = 0.0;
+        return options;
+    }
+};
+
+} // Svg2Cairo::
+
+#endif //_RENDER_OPTIONS
@@ -0,0 +1,100 @@
+/************************************************************************************
+ *   shape_index.cpp  --  This file is part of LIBYASVG.                            *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "shape_index.h"
+
+#include <algorithm>
+
+/*
+ * @fn build
+ *
+ * @brief construct the hierarchy, replacing an earlier one
+ *
+ * @param _bounds   bounds of the items (empty boxes are never found)
+ *
+ */
+void Svg2Cairo::ShapeIndex::build(std::vector<BoundingBox> _bounds) {
+    this->bounds = std::move(_bounds);
+    this->nodes.clear();
+    this->items.clear();
+
+    for(uint32_t i=0; i<this->bounds.size(); i++) {
+        if(!this->bounds[i].empty()) {
+            this->items.push_back(i);
+        }
+    }
+
+    if(!this->items.empty()) {
+        this->nodes.reserve(2 * (this->items.size() / LEAF_SIZE) + 1);
+        this->build_node(0, static_cast<uint32_t>(this->items.size()));
+    }
+}
+
+/*
+ * @fn build_node
+ *
+ * @brief construct the subtree over a range of items
+ *
+ * @param first     first item of the range
+ * @param count     number of items
+ *
+ * @return index of the node
+ */
+uint32_t Svg2Cairo::ShapeIndex::build_node(uint32_t first, uint32_t count) {
+    const uint32_t idx = static_cast<uint32_t>(this->nodes.size());
+    this->nodes.emplace_back();
+
+    BoundingBox box;
+    BoundingBox centers;
+    for(uint32_t i=first; i<first + count; i++) {
+        const BoundingBox& b = this->bounds[this->items[i]];
+        box.add(b);
+        centers.add(0.5 * (b.x1 + b.x2), 0.5 * (b.y1 + b.y2));
+    }
+    this->nodes[idx].box = box;
+
+    if(count <= LEAF_SIZE) {
+        this->nodes[idx].first = first;
+        this->nodes[idx].count = count;
+        return idx;
+    }
+
+    // splitting at the median keeps the depth at log2(n), well within the query stack
+    const bool split_x = centers.width() >= centers.height();
+    const uint32_t half = count / 2;
+    auto begin = this->items.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [this, split_x](uint32_t a, uint32_t b) {
+        const BoundingBox& ba = this->bounds[a];
+        const BoundingBox& bb = this->bounds[b];
+        return split_x ? (ba.x1 + ba.x2) < (bb.x1 + bb.x2) : (ba.y1 + ba.y2) < (bb.y1 + bb.y2);
+    });
+
+    this->build_node(first, half);      // first child directly follows its parent
+    const uint32_t second = this->build_node(first + half, count - half);
+    this->nodes[idx].first = second;
+    this->nodes[idx].count = 0;
+    return idx;
+}
@@ -0,0 +1,155 @@
+/************************************************************************************
+ *   shape_index.h  --  This file is part of LIBYASVG.                              *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _SHAPE_INDEX
+#define _SHAPE_INDEX
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * SHAPE INDEX
+ *****************************************************************/
+
+/*
+ * @class ShapeIndex
+ *
+ * @brief bounding volume hierarchy over the bounds of a fixed set of items
+ *
+ * The hierarchy is a binary tree stored in a single array. Nodes are split
+ * at the median center along their longest axis, such that the tree is
+ * balanced and a query visiting a few items takes logarithmic time in the
+ * number of items. Items are identified by their position in the vector
+ * of bounds passed to build.
+ *
+ */
+class ShapeIndex {
+private:
+    /*
+     * @class Node
+     *
+     * @brief node of the hierarchy
+     *
+     */
+    struct Node {
+        BoundingBox box;        //!< bounds of all items below the node
+        uint32_t first;         //!< first item (leaf) or index of the second child (inner node)
+        uint32_t count;         //!< number of items (0 for an inner node, of which the first child follows)
+    };
+
+    std::vector<Node> nodes;            //!< nodes in depth-first order (root first)
+    std::vector<uint32_t> items;        //!< items ordered by leaf
+    std::vector<BoundingBox> bounds;    //!< bounds by item
+
+    static const uint32_t LEAF_SIZE = 4;    //!< largest number of items in a leaf
+
+public:
+    /*
+     * @fn build
+     *
+     * @brief construct the hierarchy, replacing an earlier one
+     *
+     * @param _bounds   bounds of the items (empty boxes are never found)
+     *
+     */
+    void build(std::vector<BoundingBox> _bounds);
+
+    /*
+     * @fn query
+     *
+     * @brief visit the items of which the bounds overlap a region
+     *
+     * Items are visited in no particular order.
+     *
+     * @param region    region to search
+     * @param visit     function called with the index of each item found
+     *
+     */
+    template<typename F>
+    void query(const BoundingBox& region, F visit) const {
+        if(this->nodes.empty() || region.empty()) {
+            return;
+        }
+
+        uint32_t stack[64];
+        unsigned int depth = 0;
+        stack[depth++] = 0;
+        while(depth > 0) {
+            const uint32_t idx = stack[--depth];
+            const Node& node = this->nodes[idx];
+            if(!overlaps(node.box, region)) {
+                continue;
+            }
+
+            if(node.count > 0) {
+                for(uint32_t i=node.first; i<node.first + node.count; i++) {
+                    if(overlaps(this->bounds[this->items[i]], region)) {
+                        visit(this->items[i]);
+                    }
+                }
+            } else {
+                stack[depth++] = node.first;
+                stack[depth++] = idx + 1;
+            }
+        }
+    }
+
+    /*
+     * @fn get_nr_items
+     *
+     * @brief get the number of indexed items
+     *
+     * @return number of items
+     */
+    inline size_t get_nr_items() const {
+        return this->bounds.size();
+    }
+
+private:
+    /*
+     * @fn build_node
+     *
+     * @brief construct the subtree over a range of items
+     *
+     * @param first     first item of the range
+     * @param count     number of items
+     *
+     * @return index of the node
+     */
+    uint32_t build_node(uint32_t first, uint32_t count);
+
+    static inline bool overlaps(const BoundingBox& a, const BoundingBox& b) {
+        return a.x1 <= b.x2 && a.x2 >= b.x1 && a.y1 <= b.y2 && a.y2 >= b.y1;
+    }
+};
+
+} // Svg2Cairo::
+
+#endif //_SHAPE_INDEX
@@ -0,0 +1,96 @@
+/************************************************************************************
+ *   sprite_cache.cpp  --  This file is part of LIBYASVG.                           *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "sprite_cache.h"
+
+#include <cmath>
+#include <mutex>
+
+/*****************************************************************
+ * SPRITE CACHE
+ *****************************************************************/
+
+Svg2Cairo::SpriteCache::SpriteCache(std::pmr::memory_resource* resource) : sprites(resource) {}
+
+Svg2Cairo::SpriteCache::~SpriteCache() {
+    for(const auto& sprite : this->sprites) {
+        cairo_surface_destroy(sprite.second);
+    }
+}
+
+void Svg2Cairo::SpriteCache::draw(cairo_t* cr, double x, double y, double radius, double scale, cairo_antialias_t antialias) {
+    const int bucket = (int)std::lround(radius * SPRITE_RADIUS_STEPS);
+
+    // split the center into the pixel holding it and the subpixel position within that pixel
+    const double px = std::floor(x);
+    const double py = std::floor(y);
+    const int sx = std::min(SPRITE_OFFSETS - 1, (int)((x - px) * SPRITE_OFFSETS));
+    const int sy = std::min(SPRITE_OFFSETS - 1, (int)((y - py) * SPRITE_OFFSETS));
+
+    cairo_surface_t* sprite = this->get_sprite(bucket, sx, sy, antialias);
+    const int pad = get_padding(bucket);
+
+    // the sprite is placed at whole pixels, such that it is composited without resampling
+    cairo_identity_matrix(cr);
+    if(scale != 1.0) {
+        cairo_scale(cr, 1.0 / scale, 1.0 / scale);
+    }
+    cairo_mask_surface(cr, sprite, px - pad, py - pad);
+}
+
+cairo_surface_t* Svg2Cairo::SpriteCache::get_sprite(int bucket, int sx, int sy, cairo_antialias_t antialias) {
+    const uint32_t key = ((uint32_t)bucket << 12) | ((uint32_t)antialias << 8) | (sx << 4) | sy;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(this->mtx);
+        auto it = this->sprites.find(key);
+        if(it != this->sprites.end()) {
+            return it->second;
+        }
+    }
+
+    const int pad = get_padding(bucket);
+    const int size = 2 * pad + 1;
+    cairo_surface_t* sprite = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+    cairo_t* scr = cairo_create(sprite);
+    cairo_set_antialias(scr, antialias);
+    cairo_arc(scr,
+              pad + (sx + 0.5) / SPRITE_OFFSETS,
+              pad + (sy + 0.5) / SPRITE_OFFSETS,
+              (double)bucket / SPRITE_RADIUS_STEPS,
+              0.0, 2 * M_PI);
+    cairo_fill(scr);
+    cairo_destroy(scr);
+    cairo_surface_flush(sprite);
+
+    std::unique_lock<std::shared_mutex> lock(this->mtx);
+    auto result = this->sprites.emplace(key, sprite);
+    if(!result.second) {
+        // created concurrently by another thread
+        cairo_surface_destroy(sprite);
+    }
+    return result.first->second;
+}
@@ -0,0 +1,132 @@
+/************************************************************************************
+ *   sprite_cache.h  --  This file is part of LIBYASVG.                             *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _SPRITE_CACHE
+#define _SPRITE_CACHE
+
+#include <cairo.h>
+#include <memory_resource>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * SPRITE CACHE
+ *****************************************************************/
+
+/*
+ * @class SpriteCache
+ *
+ * @brief antialiased masks of small filled circles
+ *
+ * A sprite holds the coverage (A8) of a circle whose radius is rounded
+ * to 1/SPRITE_RADIUS_STEPS pixel and whose center lies at one of
+ * SPRITE_OFFSETS x SPRITE_OFFSETS subpixel positions. Circles are drawn
+ * by masking the current source with the sprite at an integer pixel
+ * position, so the color is not part of the key and a single sprite
+ * serves every paint. The error with respect to filling the exact
+ * outline is at most 1/(2*SPRITE_RADIUS_STEPS) pixel in radius and
+ * 1/(2*SPRITE_OFFSETS) pixel in position.
+ *
+ * Sprites are created on first use and shared by all threads drawing
+ * the document.
+ *
+ */
+class SpriteCache {
+public:
+    static const int SPRITE_RADIUS_STEPS = 8;   //!< radius buckets per pixel
+    static const int SPRITE_OFFSETS = 4;        //!< subpixel positions per pixel and axis
+    static constexpr double SPRITE_MAX_RADIUS = 32.0;   //!< largest radius drawn from a sprite
+
+private:
+    std::pmr::unordered_map<uint32_t, cairo_surface_t*> sprites;   //!< sprites by key
+    mutable std::shared_mutex mtx;              //!< guards the sprites
+
+public:
+    /*
+     * @fn SpriteCache
+     *
+     * @brief SpriteCache constructor
+     *
+     * @param resource memory resource holding the table of sprites
+     *
+     */
+    SpriteCache(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    ~SpriteCache();
+
+    SpriteCache(const SpriteCache&) = delete;
+    SpriteCache& operator=(const SpriteCache&) = delete;
+
+    /*
+     * @fn draw
+     *
+     * @brief fill a circle given in pixels of the target with the current source
+     *
+     * The transformation of cr is reset to the inverse of the device scale,
+     * such that a unit is a pixel of the target.
+     *
+     * @param cr        pointer to cairo object
+     * @param x         center x in pixels
+     * @param y         center y in pixels
+     * @param radius    radius in pixels (at most SPRITE_MAX_RADIUS)
+     * @param scale     device scale of the target (pixels per device unit)
+     * @param antialias antialiasing mode of the sprite
+     *
+     */
+    void draw(cairo_t* cr, double x, double y, double radius, double scale, cairo_antialias_t antialias);
+
+private:
+    /*
+     * @fn get_sprite
+     *
+     * @brief find or create a sprite
+     *
+     * @param bucket    radius in steps of 1/SPRITE_RADIUS_STEPS pixel
+     * @param sx        subpixel offset in x
+     * @param sy        subpixel offset in y
+     * @param antialias antialiasing mode
+     *
+     * @return sprite (owned by the cache)
+     */
+    cairo_surface_t* get_sprite(int bucket, int sx, int sy, cairo_antialias_t antialias);
+
+    /*
+     * @fn get_padding
+     *
+     * @brief distance between the edge of a sprite and the pixel holding the center
+     *
+     */
+    static inline int get_padding(int bucket) {
+        return (bucket + SPRITE_RADIUS_STEPS - 1) / SPRITE_RADIUS_STEPS + 1;
+    }
+};
+
+} // Svg2Cairo::
+
+#endif //_SPRITE_CACHE
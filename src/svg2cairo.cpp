@@ -25,6 +25,206 @@
  ************************************************************************************/
 
 #include "svg2cairo.h"
+#include "animation.h"
+#include "worker_pool.h"
+#include "kernels.h"
+
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <condition_variable>
+#include <exception>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace {
+    // paths with fewer commands than this are always drawn exactly
+    const size_t LOD_MIN_COMMANDS = 16;
+
+    // relative margin added to the estimated bounds of lazily compiled paths
+    const double DEFER_MARGIN = 1e-4;
+
+    // paths with at least this many points are transformed to device space before they are replayed
+    const size_t PRETRANSFORM_MIN_POINTS = 32;
+
+    // locks guarding the caches of simplified paths, shared by hashing the path address
+    std::mutex lod_locks[32];
+
+    // upper bound on the number of solid patterns created per document
+    const size_t MAX_CACHED_PATTERNS = 4096;
+
+    // largest number of pixels of the canvas copy kept by a progressive draw (64 MiB in ARGB32)
+    const double MAX_LAYER_PIXELS = 4096.0 * 4096.0;
+
+    // number of shapes gathered by a progressive draw between checks of the deadline
+    const size_t COLLECT_CHECK_INTERVAL = 64;
+
+    // tolerance of retained outlines; these are built under the identity matrix but may be
+    // drawn scaled up or at a fine tolerance, so arcs are split for a much smaller error
+    const double RETAIN_TOLERANCE = 1e-4;
+
+    // number of elements the streaming loader may read ahead of the drawing
+    const size_t STREAM_QUEUE_DEPTH = 1024;
+
+    /*
+     * @class StreamChannel
+     *
+     * @brief bounded queue passing items from one producer to one consumer
+     *
+     */
+    template<typename T>
+    class StreamChannel {
+    private:
+        std::deque<T> items;                //!< items not yet taken
+        size_t capacity;                    //!< maximum number of waiting items
+        bool closed = false;                //!< the producer has finished
+        bool aborted = false;               //!< the consumer has stopped
+        std::mutex mtx;                     //!< guards the queue
+        std::condition_variable cv_items;   //!< signals items (or the end)
+        std::condition_variable cv_space;   //!< signals room (or an abort)
+
+    public:
+        StreamChannel(size_t _capacity) : capacity(_capacity) {}
+
+        // add an item, waiting while the queue is full; false once the consumer stopped
+        bool push(T&& item) {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->cv_space.wait(lock, [this]() { return this->aborted || this->items.size() < this->capacity; });
+            if(this->aborted) {
+                return false;
+            }
+            this->items.push_back(std::move(item));
+            this->cv_items.notify_one();
+            return true;
+        }
+
+        // take the next item; false when the producer has finished and the queue is empty
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->cv_items.wait(lock, [this]() { return this->closed || !this->items.empty(); });
+            if(this->items.empty()) {
+                return false;
+            }
+            item = std::move(this->items.front());
+            this->items.pop_front();
+            this->cv_space.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->closed = true;
+            this->cv_items.notify_one();
+        }
+
+        void abort() {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->aborted = true;
+            this->items.clear();
+            this->cv_space.notify_one();
+        }
+    };
+
+    std::mutex& lod_lock(const void* ptr) {
+        return lod_locks[(reinterpret_cast<uintptr_t>(ptr) >> 4) % 32];
+    }
+
+    /*
+     * @fn to_double
+     *
+     * @brief convert a range of characters to a number without allocating
+     *
+     * Accepts exactly the strings accepted by boost::lexical_cast<double>
+     * that can occur in a path (no letters).
+     *
+     * @param begin start of the range
+     * @param end   end of the range
+     * @param value receives the number
+     *
+     * @return whether the complete range is a valid number
+     */
+    bool to_double(const char* begin, const char* end, double* value) {
+        const size_t len = end - begin;
+        if(len == 0 || std::isspace((unsigned char)*begin)) {
+            return false;
+        }
+
+        char buffer[64];
+        if(len >= sizeof(buffer)) {
+            const std::string str(begin, end);
+            char* stop;
+            *value = std::strtod(str.c_str(), &stop);
+            return stop == str.c_str() + len;
+        }
+
+        std::memcpy(buffer, begin, len);
+        buffer[len] = '\0';
+        char* stop;
+        *value = std::strtod(buffer, &stop);
+        return stop == buffer + len;
+    }
+
+    /*
+     * @fn require_double
+     *
+     * @brief convert a range of characters to a number, raising an error for invalid numbers
+     */
+    double require_double(const char* begin, const char* end) {
+        double value;
+        if(!to_double(begin, end, &value)) {
+            throw boost::bad_lexical_cast();
+        }
+        return value;
+    }
+
+    std::string_view trim(const char* begin, const char* end) {
+        while(begin != end && std::isspace((unsigned char)*begin)) {
+            ++begin;
+        }
+        while(end != begin && std::isspace((unsigned char)*(end - 1))) {
+            --end;
+        }
+        return std::string_view(begin, end - begin);
+    }
+
+    /*
+     * @fn apply_fill_property
+     *
+     * @brief set the fill color or fill opacity of a shape
+     *
+     * Accepts presentation attributes as well as style declarations;
+     * other properties and invalid values are ignored.
+     *
+     * @param shape     shape receiving the property
+     * @param name      property name
+     * @param value     property value
+     */
+    void apply_fill_property(Svg2Cairo::Shape* shape, std::string_view name, std::string_view value) {
+        if(name == "fill") {
+            Color color;
+            if(value == "none") {
+                shape->set_color(Color(0, 0, 0, 0));
+            } else if(Color::parse(value.data(), value.data() + value.size(), &color)) {
+                shape->set_color(color);
+            }
+        } else if(name == "fill-opacity") {
+            const bool percent = !value.empty() && value.back() == '%';
+            if(percent) {
+                value.remove_suffix(1);
+            }
+
+            double opacity;
+            if(to_double(value.data(), value.data() + value.size(), &opacity)) {
+                if(percent) {
+                    opacity /= 100.0;
+                }
+                shape->set_fill_opacity(std::lround(255.0 * std::min(1.0, std::max(0.0, opacity))));
+            }
+        }
+    }
+}
 
 /*****************************************************************
  * CAIRO TRANSLATE OPERATION
@@ -49,10 +249,22 @@ Svg2Cairo::Translate::Translate(double _x, double _y) : x(_x), y(_y) {}
  * @param cr pointer to cairo object
  *
  */
-void Svg2Cairo::Translate::draw(cairo_t* cr) {
+void Svg2Cairo::Translate::draw(cairo_t* cr) const {
     cairo_translate(cr, x, y);
 }
 
+/*
+ * @fn apply
+ *
+ * @brief perform translation on a transformation matrix
+ *
+ * @param m pointer to matrix
+ *
+ */
+void Svg2Cairo::Translate::apply(cairo_matrix_t* m) const {
+    cairo_matrix_translate(m, x, y);
+}
+
 /*****************************************************************
  * CAIRO ROTATE OPERATION
  *****************************************************************/
@@ -75,17 +287,68 @@ Svg2Cairo::Rotate::Rotate(double _angle) : angle(_angle / 180.0 * M_PI) {}
  * @param cr pointer to cairo object
  *
  */
-void Svg2Cairo::Rotate::draw(cairo_t* cr) {
+void Svg2Cairo::Rotate::draw(cairo_t* cr) const {
     cairo_rotate(cr, angle);
 }
 
+/*
+ * @fn apply
+ *
+ * @brief perform rotation on a transformation matrix
+ *
+ * @param m pointer to matrix
+ *
+ */
+void Svg2Cairo::Rotate::apply(cairo_matrix_t* m) const {
+    cairo_matrix_rotate(m, angle);
+}
+
 /*****************************************************************
  * SVG2CAIRO SHAPE CLASS
  *****************************************************************/
 
-Svg2Cairo::Shape::Shape(unsigned int _type) : type(_type) {}
+Svg2Cairo::Shape::Shape(unsigned int _type) :
+    type(_type), index(-1), has_color(false), fill_opacity(255), has_fill_opacity(false), retained_path(nullptr) {}
+
+Svg2Cairo::Shape::~Shape() {
+    if(this->retained_path != nullptr) {
+        cairo_path_destroy(this->retained_path);
+    }
+}
+
+void Svg2Cairo::Shape::draw(cairo_t* cr) const {
+    this->draw(cr, this->color.with_opacity(this->fill_opacity));
+}
+
+void Svg2Cairo::Shape::draw(cairo_t* cr, const Color& _color) const {
+    this->cairo_set_color(cr, _color);
+    if(this->retained_path != nullptr) {
+        cairo_append_path(cr, this->retained_path);
+    } else {
+        this->create_path(cr);
+    }
+    cairo_fill(cr);
+}
+
+void Svg2Cairo::Shape::draw(cairo_t* cr, const Color& _color, double tolerance) const {
+    this->cairo_set_color(cr, _color);
+    this->fill(cr, tolerance);
+}
+
+void Svg2Cairo::Shape::fill(cairo_t* cr, double tolerance) const {
+    if(this->retained_path != nullptr) {
+        cairo_append_path(cr, this->retained_path);
+    } else {
+        this->create_path(cr, tolerance);
+    }
+    cairo_fill(cr);
+}
+
+void Svg2Cairo::Shape::create_path(cairo_t* cr, double) const {
+    this->create_path(cr);
+}
 
-void Svg2Cairo::Shape::handle_transform(cairo_t* cr) {
+void Svg2Cairo::Shape::handle_transform(cairo_t* cr) const {
     if(this->translate) {
         this->translate->draw(cr);
     }
@@ -95,21 +358,44 @@ void Svg2Cairo::Shape::handle_transform(cairo_t* cr) {
     }
 }
 
-void Svg2Cairo::Shape::cairo_set_color(cairo_t* cr) {
-    cairo_set_source_rgb(cr, this->color.get_r(), this->color.get_g(), this->color.get_b());
+void Svg2Cairo::Shape::retain_path(cairo_t* cr) {
+    if(this->retained_path != nullptr) {
+        return;
+    }
+
+    // construct the path in the shape's own coordinate system, such that it can be appended under any transformation
+    cairo_save(cr);
+    cairo_identity_matrix(cr);
+    cairo_new_path(cr);
+    this->create_path(cr);
+    this->retained_path = cairo_copy_path(cr);
+    cairo_new_path(cr);
+    cairo_restore(cr);
+
+    if(this->retained_path->status != CAIRO_STATUS_SUCCESS) {
+        cairo_path_destroy(this->retained_path);
+        this->retained_path = nullptr;
+    }
 }
 
-/*****************************************************************
- * SVG2CAIRO CIRCLE CLASS
- *****************************************************************/
+void Svg2Cairo::Shape::get_transform(cairo_matrix_t* m) const {
+    cairo_matrix_init_identity(m);
 
-Svg2Cairo::Circle::Circle(double _cx, double _cy, double _r) :
-    Shape(SHAPE_CIRCLE), cx(_cx), cy(_cy), r(_r) {}
+    if(this->translate) {
+        this->translate->apply(m);
+    }
 
-void Svg2Cairo::Circle::draw(cairo_t* cr) {
-    this->cairo_set_color(cr);
-    cairo_arc(cr, this->cx, this->cy, this->r, 0.0, 2 * M_PI);
-    cairo_fill(cr);
+    if(this->rotate) {
+        this->rotate->apply(m);
+    }
+}
+
+void Svg2Cairo::Shape::cairo_set_color(cairo_t* cr, const Color& _color) const {
+    if(_color.is_opaque()) {
+        cairo_set_source_rgb(cr, _color.get_r(), _color.get_g(), _color.get_b());
+    } else {
+        cairo_set_source_rgba(cr, _color.get_r(), _color.get_g(), _color.get_b(), _color.get_a());
+    }
 }
 
 /*****************************************************************
@@ -122,263 +408,833 @@ void Svg2Cairo::Circle::draw(cairo_t* cr) {
  * @brief default constructor
  *
  * @param _operations string holding all operations (grabbed from XML)
+ * @param resource    memory resource holding the compiled data
+ * @param format      storage of the compiled coordinates
  *
  */
-Svg2Cairo::Path::Path(const std::string& _operations) : Shape(SHAPE_PATH), operations(_operations), operand('\0') { }
+Svg2Cairo::Path::Path(const std::string& _operations, std::pmr::memory_resource* resource, CoordinateStorage format) :
+    Shape(SHAPE_PATH), data(resource, format), source(nullptr), variants(resource) {
+    this->compile(_operations);
+}
 
 /*
- * @fn draw
+ * @fn Path
+ *
+ * @brief construct an empty path (see compile and defer)
+ *
+ * @param resource    memory resource holding the compiled data
+ * @param format      storage of the compiled coordinates
  *
- * @brief draw the path on the Cairo canvas
+ */
+Svg2Cairo::Path::Path(std::pmr::memory_resource* resource, CoordinateStorage format) :
+    Shape(SHAPE_PATH), data(resource, format), source(nullptr), variants(resource) {}
+
+Svg2Cairo::Path::~Path() {
+    std::pmr::polymorphic_allocator<PathData> alloc(this->variants.get_allocator().resource());
+    for(const auto& v : this->variants) {
+        if(v.second != nullptr) {
+            v.second->~PathData();
+            alloc.deallocate(v.second, 1);
+        }
+    }
+}
+
+/*
+ * @fn create_path
+ *
+ * @brief replay the compiled path on the Cairo canvas
  *
  * @param cr                pointer to cairo object
  *
  */
-void Svg2Cairo::Path::draw(cairo_t* cr) {
-    // set the color to fill this path
-    this->cairo_set_color(cr);
+void Svg2Cairo::Path::create_path(cairo_t* cr) const {
+    this->ensure_compiled();
+    replay(cr, this->data);
+}
 
-    // loop over characters
-    for(char c : this->operations) {
-        if((c >= 65 && c <= 90) ||
-           (c >= 97 && c <= 122)) {
-            if(this->operand != '\0') {
-                // execute operand
-                this->perform_operation(cr, c);
-            } else {
-                this->operand = c;
+/*
+ * @fn create_path
+ *
+ * @brief replay a simplified variant of the path on the Cairo canvas
+ *
+ * @param cr                pointer to cairo object
+ * @param tolerance         maximum deviation in device pixels
+ *
+ */
+void Svg2Cairo::Path::create_path(cairo_t* cr, double tolerance) const {
+    this->ensure_compiled();
+
+    if(tolerance <= 0.0 || this->data.commands.size() < LOD_MIN_COMMANDS) {
+        replay(cr, this->data);
+        return;
+    }
+
+    cairo_matrix_t m;
+    cairo_get_matrix(cr, &m);
+    const double scale = max_scale(m) * device_scale(cr);
+    if(!(scale > 0.0) || !std::isfinite(scale)) {
+        replay(cr, this->data);
+        return;
+    }
+
+    // all scales within [2^bucket, 2^(bucket+1)) share a variant
+    const int bucket = (int)std::floor(std::log2(scale));
+
+    const PathData* variant = nullptr;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(lod_lock(this));
+        for(const auto& v : this->variants) {
+            if(v.first == bucket) {
+                variant = v.second;
+                found = true;
+                break;
             }
-        } else {
-            // store character in coordinate string
-            this->coordinates += c;
         }
     }
-    // close the string
-    this->perform_operation(cr, '\0');
 
-    // always close the path, regardless whether 'Z' operand was called
-    cairo_close_path(cr);
+    if(!found) {
+        // build the variant for the largest scale in the bucket, such that the error bound holds for the whole bucket
+        auto simplified = this->simplify(tolerance / std::ldexp(1.0, bucket + 1));
 
-    // fill the path with the current color
-    cairo_fill(cr);
+        std::lock_guard<std::mutex> lock(lod_lock(this));
+        for(const auto& v : this->variants) {
+            if(v.first == bucket) { // built concurrently by another thread
+                variant = v.second;
+                found = true;
+                break;
+            }
+        }
+        if(found) {
+            // discard the duplicate
+            if(simplified != nullptr) {
+                std::pmr::polymorphic_allocator<PathData> alloc(this->variants.get_allocator().resource());
+                simplified->~PathData();
+                alloc.deallocate(simplified, 1);
+            }
+        } else {
+            variant = simplified;
+            this->variants.emplace_back(bucket, simplified);
+        }
+    }
+
+    replay(cr, variant != nullptr ? *variant : this->data);
 }
 
 /*
- * @fn perform_operation
+ * @fn replay
  *
- * @brief perform user-space rotation on cairo object
+ * @brief construct compiled path data as the current Cairo path
  *
  * @param cr                pointer to cairo object
- * @param char new_operand  char specifying the next instruction for the path
+ * @param pd                compiled path data
  *
  */
-void Svg2Cairo::Path::perform_operation(cairo_t* cr, char new_operand) {
-    // parse coordinates
-    std::vector<double> coord;
-    std::string digit;
-    bool firstdot = true;
-    if(!this->coordinates.empty()) {
-        for(char c : this->coordinates) {
-            if(c == ',' || c == ' ') {
-                try {
-                    coord.push_back(boost::lexical_cast<double>(digit));
-                } catch(const std::exception& e) {
-                    // do nothing
-                }
-                digit.clear();
-                firstdot = true;
-            } else if(c == '-') {
-                if(!digit.empty()) {
-                    coord.push_back(boost::lexical_cast<double>(digit));
-                    digit.clear();
-                    firstdot = true;
-                }
-                digit += c;
-            } else if(c == '.') {
-                if(firstdot) {
-                    firstdot = false;
+void Svg2Cairo::Path::replay(cairo_t* cr, const PathData& pd) {
+    thread_local std::vector<double> buffer;
+    thread_local std::vector<double> device;
+    const double* p = pd.points.expand(buffer);
+    const double* q = pd.params.data();
+
+    // the points of large paths are transformed to device space in bulk and
+    // passed to Cairo under the identity matrix, which skips its per-point transformation
+    cairo_matrix_t m;
+    cairo_get_matrix(cr, &m);
+    const bool pretransform = pd.points.size() >= 2 * PRETRANSFORM_MIN_POINTS &&
+                              !(m.xx == 1.0 && m.yx == 0.0 && m.xy == 0.0 && m.yy == 1.0 && m.x0 == 0.0 && m.y0 == 0.0);
+    if(pretransform) {
+        device.resize(pd.points.size());
+        transform_points(m, p, device.data(), pd.points.size() / 2);
+        p = device.data();
+        cairo_identity_matrix(cr);
+    }
+
+    for(unsigned char cmd : pd.commands) {
+        switch(cmd) {
+            case PATH_MOVE_TO:
+                cairo_move_to(cr, p[0], p[1]);
+                p += 2;
+            break;
+            case PATH_LINE_TO:
+                cairo_line_to(cr, p[0], p[1]);
+                p += 2;
+            break;
+            case PATH_CURVE_TO:
+                cairo_curve_to(cr, p[0], p[1], p[2], p[3], p[4], p[5]);
+                p += 6;
+            break;
+            case PATH_ARC:
+                cairo_save(cr);
+                if(pretransform) {
+                    // the transformed center equals the translation of m translated to the center
+                    cairo_matrix_t local = m;
+                    local.x0 = p[0];
+                    local.y0 = p[1];
+                    cairo_set_matrix(cr, &local);
                 } else {
-                    coord.push_back(boost::lexical_cast<double>(digit));
-                    digit.clear();
-                    firstdot = true;
+                    cairo_translate(cr, p[0], p[1]);
                 }
-                digit += c;
-            } else {
-                digit += c;
-            }
-        }
-        if(!digit.empty()) { // parse final digit
-            coord.push_back(boost::lexical_cast<double>(digit));
+                cairo_rotate(cr, q[0]);
+                cairo_scale(cr, q[1], q[2]);
+                cairo_arc_negative(cr, 0.0, 0.0, 1.0, q[3], q[4]);
+                cairo_restore(cr);
+                p += 2;
+                q += 5;
+            break;
+            case PATH_CLOSE:
+                cairo_close_path(cr);
+            break;
         }
     }
 
-    //
-    // execute the procedure related to the current operand
-    // a list of operands is given here: https://developer.mozilla.org/en-US/docs/Web/SVG/Tutorial/Paths
-    //
-    // note that this list in *INCOMPLETE*
-    //
-    switch(this->operand) {
-        case 'M': // move to
-            cairo_move_to(cr, coord[0], coord[1]);
-            for(unsigned int i=2; i<coord.size(); i+=2) {
-                cairo_line_to(cr, coord[i], coord[i+1]);
-            }
-        break;
-        case 'm': // relative move to
-            double x1, y1;
-            cairo_get_current_point(cr, &x1, &y1);
-            cairo_move_to(cr, x1 + coord[0], y1 + coord[1]);
-            for(unsigned int i=2; i<coord.size(); i+=2) {
-                cairo_get_current_point(cr, &x1, &y1);
-                cairo_line_to(cr, x1 + coord[i], y1 + coord[i+1]);
-            }
-        break;
-        case 'A': { // arc (not the same as a cairo, so we need to do some math here)
-            cairo_save(cr);
+    // always close the path, regardless whether 'Z' operand was called
+    cairo_close_path(cr);
 
-            // get start and stop coordinates
-            double x1, y1;
-            cairo_get_current_point(cr, &x1, &y1);
-            const double x2 = coord[5];
-            const double y2 = coord[6];
-
-            // obtain center coordinates
-            auto centercoord = this->endpoint_to_center(x1, y1, x2, y2, coord[3], coord[4], coord[0], coord[1], coord[2] / 180 * M_PI);
-            cairo_translate(cr, centercoord[0], centercoord[1]);
-            cairo_rotate(cr, coord[2] / 180 * M_PI);
-            cairo_scale(cr, coord[0], coord[1]);
-            cairo_arc_negative(cr, 0.0, 0.0, 1.0, centercoord[2], centercoord[2] + centercoord[3]);
-            cairo_restore(cr);
-        }
-        break;
-        case 'a': { // relative arc (not the same as a cairo, so we need to do some math here)
-            cairo_save(cr);
+    if(pretransform) {
+        cairo_set_matrix(cr, &m);
+    }
+}
 
-            // get start and stop coordinates
-            double x1, y1;
-            cairo_get_current_point(cr, &x1, &y1);
-            const double x2 = x1 + coord[5];
-            const double y2 = y1 + coord[6];
-
-            // obtain center coordinates
-            auto centercoord = this->endpoint_to_center(x1, y1, x2, y2, coord[3], coord[4], coord[0], coord[1], coord[2] / 180 * M_PI);
-            cairo_translate(cr, centercoord[0], centercoord[1]);
-            cairo_rotate(cr, coord[2] / 180 * M_PI);
-            cairo_scale(cr, coord[0], coord[1]);
-            cairo_arc_negative(cr, 0.0, 0.0, 1.0, centercoord[2], centercoord[2] + centercoord[3]);
-            cairo_restore(cr);
-        }
-        break;
-        case 'L': // line
-            cairo_line_to(cr, coord[0], coord[1]);
-        break;
-        case 'l': // relative line
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_line_to(cr, x + coord[0], y + coord[1]);
-        break;
-        case 'V': { // vertical line
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_line_to(cr, x, coord[0]);
-        }
-        break;
-        case 'v': { // relative vertical line
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_line_to(cr, x, y + coord[0]);
-        }
-        break;
-        case 'h': { // relative horizontal line
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_line_to(cr, x + coord[0], y);
-        }
-        break;
-        case 'H': { // horizontal line
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_line_to(cr, coord[0], y);
+/*
+ * @fn simplify
+ *
+ * @brief build a flattened and decimated variant of the path
+ *
+ * @param tolerance         maximum deviation in user space
+ *
+ * @return simplified path data (nullptr if it is not smaller than the exact path)
+ */
+Svg2Cairo::Path::PathData* Svg2Cairo::Path::simplify(double tolerance) const {
+    // the variant is built in scratch storage and only copied to the document when it is kept
+    thread_local PathBuffer scratch;
+    scratch.clear();
+    PathBuffer* pd = &scratch;
+
+    // half of the tolerance is spent on flattening, the other half on decimation
+    const double flat_tol = 0.5 * tolerance;
+    const double decimate_tol = 0.5 * tolerance;
+
+    std::vector<double> polyline;       // vertices of the current subpath
+    double sx = 0.0, sy = 0.0;          // start of the current subpath
+    bool has_point = false;             // whether a current point exists
+
+    // emit the current subpath as decimated polyline
+    auto flush = [&](bool closed) {
+        if(polyline.empty()) {
+            return;
         }
-        break;
-        case 'c': { // relative curve
-            double x,y;
-            cairo_get_current_point(cr, &x, &y);
-            cairo_save(cr);
-            cairo_translate(cr, x, y);
-            cairo_curve_to (cr, coord[0], coord[1], coord[2], coord[3], coord[4], coord[5]);
-            cairo_restore(cr);
+        std::vector<double> out;
+        simplify_polyline(polyline.data(), polyline.size() / 2, decimate_tol, out);
+        pd->commands.push_back(PATH_MOVE_TO);
+        for(size_t i=2; i<out.size(); i+=2) {
+            pd->commands.push_back(PATH_LINE_TO);
         }
-        break;
-        case 'C': { // curve
-            cairo_curve_to (cr, coord[0], coord[1], coord[2], coord[3], coord[4], coord[5]);
+        pd->points.insert(pd->points.end(), out.begin(), out.end());
+        if(closed) {
+            pd->commands.push_back(PATH_CLOSE);
         }
-        break;
-        case 'Z': { // close path
-            cairo_close_path(cr);
+        polyline.clear();
+    };
+
+    // make sure a subpath is started (Cairo implicitly starts one at the current point)
+    auto begin = [&](double x, double y) {
+        if(polyline.empty()) {
+            polyline.push_back(has_point ? sx : x);
+            polyline.push_back(has_point ? sy : y);
+            if(!has_point) {
+                sx = x;
+                sy = y;
+            }
+            has_point = true;
         }
-        break;
-        case 'z': { // close path
-            cairo_close_path(cr);
+    };
+
+    size_t cost = 0;
+    std::vector<double> buffer;
+    const double* p = this->data.points.expand(buffer);
+    const double* q = this->data.params.data();
+    for(unsigned char cmd : this->data.commands) {
+        switch(cmd) {
+            case PATH_MOVE_TO:
+                flush(false);
+                sx = p[0];
+                sy = p[1];
+                has_point = true;
+                polyline.push_back(p[0]);
+                polyline.push_back(p[1]);
+                p += 2;
+                cost += 1;
+            break;
+            case PATH_LINE_TO:
+                begin(p[0], p[1]);
+                polyline.push_back(p[0]);
+                polyline.push_back(p[1]);
+                p += 2;
+                cost += 1;
+            break;
+            case PATH_CURVE_TO: {
+                begin(p[0], p[1]);
+                const double x0 = polyline[polyline.size()-2];
+                const double y0 = polyline[polyline.size()-1];
+                flatten_curve(polyline, x0, y0, p[0], p[1], p[2], p[3], p[4], p[5], flat_tol);
+                p += 6;
+                cost += 3;
+            }
+            break;
+            case PATH_ARC: {
+                std::vector<double> arc;
+                flatten_arc(arc, p[0], p[1], q[0], q[1], q[2], q[3], q[4], flat_tol);
+                begin(arc[0], arc[1]);
+                polyline.insert(polyline.end(), arc.begin(), arc.end());
+                p += 2;
+                q += 5;
+                cost += 8;
+            }
+            break;
+            case PATH_CLOSE:
+                flush(true);
+            break;
         }
-        break;
-        default:
-            std::cerr << "Unknown operation: " << this->operand << " encountered." << std::endl;
-        break;
     }
+    flush(false);
 
-    // store the new operand as the current operand
-    this->operand = new_operand;
+    // only use the variant when it is substantially cheaper to draw
+    if(4 * pd->commands.size() >= 3 * cost) {
+        return nullptr;
+    }
 
-    // clear all coordinates (they were used in the past instruction)
-    this->coordinates.clear();
+    std::pmr::memory_resource* resource = this->variants.get_allocator().resource();
+    std::pmr::polymorphic_allocator<PathData> alloc(resource);
+    PathData* variant = alloc.allocate(1);
+    new (variant) PathData(resource, this->data.points.get_format());
+    store(*variant, scratch);
+    return variant;
 }
 
 /*
- * @fn endpoint_to_center
+ * @fn compile
  *
- * @brief convert endpoint coordinates to center coordinates
+ * @brief convert the string of SVG operations into compiled commands
  *
- * SVG uses endpoint coordinates, whereas Cairo uses center coordinates. This function convers
- * one into the other. The detailed algorithm is described here:
- * https://www.w3.org/TR/SVG/implnote.html#ArcImplementationNotes
+ * @param _operations string holding all operations (grabbed from XML)
  *
- * The implementation used here is derived from:
- * http://svn.apache.org/repos/asf/xmlgraphics/batik/branches/svg11/sources/org/apache/batik/ext/awt/geom/ExtendedGeneralPath.java
+ */
+void Svg2Cairo::Path::compile(const std::string& _operations) {
+    thread_local PathBuffer scratch;
+    scratch.clear();
+
+    PathCompiler pc;
+    pc.pd = &scratch;
+    build(_operations, pc);
+
+    store(this->data, scratch);
+    this->bounds = pc.box;
+}
+
+/*
+ * @fn defer
  *
- * @param x1    starting point x
- * @param x1    starting point y
- * @param x2    end point x
- * @param x2    end point y
- * @param fa    large arc flag (< 0.5 is false, > 0.5 is true)
- * @param fs    sweep flag (< 0.5 is false, > 0.5 is true)
- * @param rx    radius in the x direction
- * @param ry    radius in the y direction
- * @param phi   angle with respect to x-axis
+ * @brief postpone compilation of the path until it is first drawn
+ *
+ * @param _source string holding all operations (grabbed from XML)
  *
- * @return      array holding center (x,y), starting angle and extend angle
  */
-std::array<double,4> Svg2Cairo::Path::endpoint_to_center(double x1, double y1, double x2, double y2,
-                                                        double fa, double fs, double rx, double ry,
-                                                        double phi) {
+void Svg2Cairo::Path::defer(const std::string* _source) {
+    // without path data, the compiler only follows the current point and bounds the
+    // commands; arcs are bounded from their end points and radii
+    PathCompiler pc;
+    build(*_source, pc);
 
-        // Compute the half distance between the current and the final point
-        double dx2 = (x1 - x2) / 2.0;
-        double dy2 = (y1 - y2) / 2.0;
+    // the compiled end points of arcs carry the rounding of their angles (large for thin
+    // ellipses), which carries over to the points that follow
+    if(!pc.box.empty()) {
+        const double margin = DEFER_MARGIN * (1.0 + std::max(pc.box.x2 - pc.box.x1, pc.box.y2 - pc.box.y1));
+        pc.box.add(pc.box.x1 - margin, pc.box.y1 - margin);
+        pc.box.add(pc.box.x2 + margin, pc.box.y2 + margin);
+    }
 
-        // calculate the angles
-        double cos_angle = std::cos(phi);
-        double sin_angle = std::sin(phi);
+    this->bounds = pc.box;
+    this->source = _source;
+}
 
-        //
-        // Step 1 : Compute (x1p, y1p)
-        //
-        double x1p = (cos_angle * dx2 + sin_angle * dy2);
-        double y1p = (-sin_angle * dx2 + cos_angle * dy2);
+/*
+ * @fn ensure_compiled
+ *
+ * @brief compile a lazy path if this has not happened yet
+ *
+ */
+void Svg2Cairo::Path::ensure_compiled() const {
+    if(this->source == nullptr) {
+        return;
+    }
 
-        // ensure radii are large enough
-        rx = std::fabs(rx);
+    std::call_once(this->compiled, [this]() {
+        // the bounding box is already known; only the commands are stored
+        thread_local PathBuffer scratch;
+        scratch.clear();
+
+        PathCompiler pc;
+        pc.pd = &scratch;
+        pc.quiet = true;
+        build(*this->source, pc);
+        store(const_cast<PathData&>(this->data), scratch);
+    });
+}
+
+/*
+ * @fn store
+ *
+ * @brief copy compiled data into exactly sized storage
+ *
+ * Compilation appends to growing vectors; building in (reused) scratch
+ * storage and copying the result avoids leaving the discarded smaller
+ * buffers behind in the document's arena. The points are converted to
+ * the storage format of the destination.
+ *
+ * @param dest              path data receiving the copy
+ * @param src               scratch path data
+ *
+ */
+void Svg2Cairo::Path::store(PathData& dest, const PathBuffer& src) {
+    dest.commands.reserve(src.commands.size());
+    dest.commands.assign(src.commands.begin(), src.commands.end());
+    dest.points.assign(src.points.data(), src.points.size());
+    dest.params.reserve(src.params.size());
+    dest.params.assign(src.params.begin(), src.params.end());
+}
+
+/*
+ * @fn build
+ *
+ * @brief run the compiler over a string of SVG operations
+ *
+ * @param _operations       string holding all operations
+ * @param pc                compiler state
+ *
+ */
+void Svg2Cairo::Path::build(const std::string& _operations, PathCompiler& pc) {
+    const char* start = _operations.data();
+    const char* end = start + _operations.size();
+
+    // loop over characters
+    for(const char* p = start; p != end; ++p) {
+        const char c = *p;
+        if((c >= 65 && c <= 90) ||
+           (c >= 97 && c <= 122)) {
+            // convert the characters preceding the operand to coordinates
+            tokenize(pc, start, p);
+            start = p + 1;
+
+            if(pc.operand != '\0') {
+                // execute operand
+                perform_operation(pc, c);
+            } else {
+                pc.operand = c;
+            }
+        }
+    }
+    // close the string
+    tokenize(pc, start, end);
+    perform_operation(pc, '\0');
+
+    // the emitters only account for the arcs; the points are added in bulk
+    if(pc.pd != nullptr) {
+        pc.box.add(point_bounds(pc.pd->points.data(), pc.pd->points.size() / 2));
+    }
+}
+
+/*
+ * @fn tokenize
+ *
+ * @brief convert a range of the operation string to coordinates
+ *
+ * Numbers are separated by spaces and commas, or start at a minus sign
+ * or at a second decimal point. Tokens that are not a valid number are
+ * skipped when followed by a separator and raise an error otherwise.
+ *
+ * @param pc                compiler state receiving the coordinates
+ * @param begin             start of the range
+ * @param end               end of the range
+ *
+ */
+void Svg2Cairo::Path::tokenize(PathCompiler& pc, const char* begin, const char* end) {
+    const char* token = begin;  // start of the current number
+    bool firstdot = true;
+    double value;
+
+    for(const char* p = begin; p != end; ++p) {
+        const char c = *p;
+        if(c == ',' || c == ' ') {
+            if(to_double(token, p, &value)) {
+                pc.coord.push_back(value);
+            }
+            token = p + 1;
+            firstdot = true;
+        } else if(c == '-') {
+            if(p != token) {
+                pc.coord.push_back(require_double(token, p));
+                token = p;
+                firstdot = true;
+            }
+        } else if(c == '.') {
+            if(firstdot) {
+                firstdot = false;
+            } else {
+                pc.coord.push_back(require_double(token, p));
+                token = p;
+                firstdot = true;
+            }
+        }
+    }
+    if(token != end) { // parse final digit
+        pc.coord.push_back(require_double(token, end));
+    }
+}
+
+/*
+ * @fn perform_operation
+ *
+ * @brief compile the current operand into path commands
+ *
+ * @param pc                compiler state
+ * @param char new_operand  char specifying the next instruction for the path
+ *
+ */
+void Svg2Cairo::Path::perform_operation(PathCompiler& pc, char new_operand) {
+    const std::vector<double>& coord = pc.coord;
+
+    // skip instructions that do not carry enough coordinates
+    size_t required = 0;
+    switch(pc.operand) {
+        case 'M': case 'm': case 'L': case 'l': required = 2; break;
+        case 'V': case 'v': case 'H': case 'h': required = 1; break;
+        case 'C': case 'c': required = 6; break;
+        case 'A': case 'a': required = 7; break;
+        default: break;
+    }
+    if(coord.size() < required) {
+        if(!pc.quiet) std::cerr << "Incomplete operation: " << pc.operand << " encountered." << std::endl;
+        pc.operand = new_operand;
+        pc.coord.clear();
+        return;
+    }
+
+    //
+    // execute the procedure related to the current operand
+    // a list of operands is given here: https://developer.mozilla.org/en-US/docs/Web/SVG/Tutorial/Paths
+    //
+    // note that this list in *INCOMPLETE*
+    //
+    switch(pc.operand) {
+        case 'M': // move to
+            move_to(pc, coord[0], coord[1]);
+            for(unsigned int i=2; i+1<coord.size(); i+=2) {
+                line_to(pc, coord[i], coord[i+1]);
+            }
+        break;
+        case 'm': // relative move to
+            move_to(pc, pc.x + coord[0], pc.y + coord[1]);
+            for(unsigned int i=2; i+1<coord.size(); i+=2) {
+                line_to(pc, pc.x + coord[i], pc.y + coord[i+1]);
+            }
+        break;
+        case 'A': // arc (not the same as a cairo, so we need to do some math here)
+            arc_to(pc, coord[5], coord[6], coord);
+        break;
+        case 'a': // relative arc (not the same as a cairo, so we need to do some math here)
+            arc_to(pc, pc.x + coord[5], pc.y + coord[6], coord);
+        break;
+        case 'L': // line
+            line_to(pc, coord[0], coord[1]);
+        break;
+        case 'l': // relative line
+            line_to(pc, pc.x + coord[0], pc.y + coord[1]);
+        break;
+        case 'V': // vertical line
+            line_to(pc, pc.x, coord[0]);
+        break;
+        case 'v': // relative vertical line
+            line_to(pc, pc.x, pc.y + coord[0]);
+        break;
+        case 'h': // relative horizontal line
+            line_to(pc, pc.x + coord[0], pc.y);
+        break;
+        case 'H': // horizontal line
+            line_to(pc, coord[0], pc.y);
+        break;
+        case 'c': { // relative curve
+            const double x = pc.x;
+            const double y = pc.y;
+            curve_to(pc, x + coord[0], y + coord[1], x + coord[2], y + coord[3], x + coord[4], y + coord[5]);
+        }
+        break;
+        case 'C': // curve
+            curve_to(pc, coord[0], coord[1], coord[2], coord[3], coord[4], coord[5]);
+        break;
+        case 'Z': // close path
+            close_path(pc);
+        break;
+        case 'z': // close path
+            close_path(pc);
+        break;
+        default:
+            if(!pc.quiet) std::cerr << "Unknown operation: " << pc.operand << " encountered." << std::endl;
+        break;
+    }
+
+    // store the new operand as the current operand
+    pc.operand = new_operand;
+
+    // clear all coordinates (they were used in the past instruction)
+    pc.coord.clear();
+}
+
+/*
+ * @fn move_to
+ *
+ * @brief add a move_to command to the compiled path
+ */
+void Svg2Cairo::Path::move_to(PathCompiler& pc, double x, double y) {
+    if(pc.pd != nullptr) {
+        pc.pd->commands.push_back(PATH_MOVE_TO);
+        pc.pd->points.insert(pc.pd->points.end(), {x, y});
+    } else {
+        pc.box.add(x, y);
+    }
+    pc.has_point = true;
+    pc.x = pc.sx = x;
+    pc.y = pc.sy = y;
+}
+
+/*
+ * @fn line_to
+ *
+ * @brief add a line_to command to the compiled path
+ */
+void Svg2Cairo::Path::line_to(PathCompiler& pc, double x, double y) {
+    // a line without a current point behaves as move_to in Cairo
+    if(!pc.has_point) {
+        pc.sx = x;
+        pc.sy = y;
+    }
+    if(pc.pd != nullptr) {
+        pc.pd->commands.push_back(PATH_LINE_TO);
+        pc.pd->points.insert(pc.pd->points.end(), {x, y});
+    } else {
+        pc.box.add(x, y);
+    }
+    pc.has_point = true;
+    pc.x = x;
+    pc.y = y;
+}
+
+/*
+ * @fn curve_to
+ *
+ * @brief add a curve_to command to the compiled path
+ */
+void Svg2Cairo::Path::curve_to(PathCompiler& pc, double x1, double y1, double x2, double y2, double x3, double y3) {
+    if(!pc.has_point) {
+        pc.sx = x1;
+        pc.sy = y1;
+    }
+
+    // the curve lies within the convex hull of its control points, which are part of the bounds
+    if(pc.pd != nullptr) {
+        pc.pd->commands.push_back(PATH_CURVE_TO);
+        pc.pd->points.insert(pc.pd->points.end(), {x1, y1, x2, y2, x3, y3});
+    } else {
+        pc.box.add(x1, y1);
+        pc.box.add(x2, y2);
+        pc.box.add(x3, y3);
+    }
+    pc.has_point = true;
+    pc.x = x3;
+    pc.y = y3;
+}
+
+/*
+ * @fn arc_to
+ *
+ * @brief add an (elliptical) arc command to the compiled path
+ *
+ * @param pc    compiler state
+ * @param x2    end point x
+ * @param y2    end point y
+ * @param coord arc parameters (rx, ry, phi, fa, fs) as given in the SVG
+ */
+void Svg2Cairo::Path::arc_to(PathCompiler& pc, double x2, double y2, const std::vector<double>& coord) {
+    if(pc.pd == nullptr) {
+        estimate_arc(pc, x2, y2, coord);
+        return;
+    }
+
+    const double phi = coord[2] / 180 * M_PI;
+
+    // obtain center coordinates
+    auto centercoord = endpoint_to_center(pc.x, pc.y, x2, y2, coord[3], coord[4], coord[0], coord[1], phi);
+    const double angle1 = centercoord[2];
+    const double angle2 = centercoord[2] + centercoord[3];
+
+    pc.pd->commands.push_back(PATH_ARC);
+    pc.pd->points.insert(pc.pd->points.end(), {centercoord[0], centercoord[1]});
+    pc.pd->params.insert(pc.pd->params.end(), {phi, coord[0], coord[1], angle1, angle2});
+
+    // the arc lies within the circle enclosing the complete ellipse
+    const double r = std::max(std::fabs(coord[0]), std::fabs(coord[1]));
+    pc.box.add(centercoord[0] - r, centercoord[1] - r);
+    pc.box.add(centercoord[0] + r, centercoord[1] + r);
+
+    // Cairo starts a new subpath at the beginning of the arc if there is no current point
+    if(!pc.has_point) {
+        const double ex = coord[0] * std::cos(angle1);
+        const double ey = coord[1] * std::sin(angle1);
+        pc.sx = centercoord[0] + std::cos(phi) * ex - std::sin(phi) * ey;
+        pc.sy = centercoord[1] + std::sin(phi) * ex + std::cos(phi) * ey;
+    }
+
+    // the current point is placed at the end of the arc
+    const double ex = coord[0] * std::cos(angle2);
+    const double ey = coord[1] * std::sin(angle2);
+    pc.has_point = true;
+    pc.x = centercoord[0] + std::cos(phi) * ex - std::sin(phi) * ey;
+    pc.y = centercoord[1] + std::sin(phi) * ex + std::cos(phi) * ey;
+}
+
+/*
+ * @fn estimate_arc
+ *
+ * @brief bound an (elliptical) arc and advance the current point without converting it
+ *
+ * Only the center is determined (steps 1 to 3 of endpoint_to_center); the
+ * arc lies within the circle enclosing the complete ellipse around it. As
+ * in arc_to, the arc is drawn with the radii as given: radii too small to
+ * span the chord leave the arc short of the requested end point, and
+ * negative radii mirror it about the center.
+ *
+ * @param pc    compiler state
+ * @param x2    end point x
+ * @param y2    end point y
+ * @param coord arc parameters (rx, ry, phi, fa, fs) as given in the SVG
+ */
+void Svg2Cairo::Path::estimate_arc(PathCompiler& pc, double x2, double y2, const std::vector<double>& coord) {
+    const double x1 = pc.x;
+    const double y1 = pc.y;
+    const double phi = coord[2] / 180 * M_PI;
+    const double cos_angle = std::cos(phi);
+    const double sin_angle = std::sin(phi);
+
+    // end points relative to their midpoint, in the frame of the ellipse
+    const double dx2 = (x1 - x2) / 2.0;
+    const double dy2 = (y1 - y2) / 2.0;
+    const double x1p = cos_angle * dx2 + sin_angle * dy2;
+    const double y1p = -sin_angle * dx2 + cos_angle * dy2;
+
+    // radii scaled up to span the chord
+    double rx = std::fabs(coord[0]);
+    double ry = std::fabs(coord[1]);
+    double scale = 1.0;
+    const double radii_check = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+    if(radii_check > 1) {
+        scale = std::sqrt(radii_check);
+        rx *= scale;
+        ry *= scale;
+    }
+
+    // center in the frame of the ellipse and in user space
+    const double Prx = rx * rx;
+    const double Pry = ry * ry;
+    const double sign = std::fabs(coord[3] - coord[4]) < 1e-3 ? -1.0 : 1.0;
+    double sq = ((Prx*Pry)-(Prx*y1p*y1p)-(Pry*x1p*x1p)) / ((Prx*y1p*y1p)+(Pry*x1p*x1p));
+    sq = (sq < 0) ? 0 : sq;
+    const double cx1 = sign * std::sqrt(sq) * ((rx * y1p) / ry);
+    const double cy1 = sign * std::sqrt(sq) * -((ry * x1p) / rx);
+    const double cx = (x1 + x2) / 2.0 + (cos_angle * cx1 - sin_angle * cy1);
+    const double cy = (y1 + y2) / 2.0 + (sin_angle * cx1 + cos_angle * cy1);
+
+    // the arc lies within the circle enclosing the complete ellipse
+    const double r = std::max(std::fabs(coord[0]), std::fabs(coord[1]));
+    pc.box.add(cx - r, cy - r);
+    pc.box.add(cx + r, cy + r);
+
+    // point of the drawn arc at the angle of an end point (relative to the center, in the frame of the ellipse)
+    const double fx = (coord[0] < 0 ? -1.0 : 1.0) / scale;
+    const double fy = (coord[1] < 0 ? -1.0 : 1.0) / scale;
+    auto arc_point = [&](double ux, double uy, double* x, double* y) {
+        *x = cx + cos_angle * ux * fx - sin_angle * uy * fy;
+        *y = cy + sin_angle * ux * fx + cos_angle * uy * fy;
+    };
+
+    // Cairo starts a new subpath at the beginning of the arc if there is no current point
+    if(!pc.has_point) {
+        arc_point(x1p - cx1, y1p - cy1, &pc.sx, &pc.sy);
+    }
+
+    pc.has_point = true;
+    arc_point(-x1p - cx1, -y1p - cy1, &pc.x, &pc.y);
+}
+
+/*
+ * @fn close_path
+ *
+ * @brief add a close_path command to the compiled path
+ */
+void Svg2Cairo::Path::close_path(PathCompiler& pc) {
+    if(pc.pd != nullptr) {
+        pc.pd->commands.push_back(PATH_CLOSE);
+    }
+
+    // after closing, Cairo places the current point at the start of the subpath
+    if(pc.has_point) {
+        pc.x = pc.sx;
+        pc.y = pc.sy;
+    }
+}
+
+/*
+ * @fn endpoint_to_center
+ *
+ * @brief convert endpoint coordinates to center coordinates
+ *
+ * SVG uses endpoint coordinates, whereas Cairo uses center coordinates. This function convers
+ * one into the other. The detailed algorithm is described here:
+ * https://www.w3.org/TR/SVG/implnote.html#ArcImplementationNotes
+ *
+ * The implementation used here is derived from:
+ * http://svn.apache.org/repos/asf/xmlgraphics/batik/branches/svg11/sources/org/apache/batik/ext/awt/geom/ExtendedGeneralPath.java
+ *
+ * @param x1    starting point x
+ * @param x1    starting point y
+ * @param x2    end point x
+ * @param x2    end point y
+ * @param fa    large arc flag (< 0.5 is false, > 0.5 is true)
+ * @param fs    sweep flag (< 0.5 is false, > 0.5 is true)
+ * @param rx    radius in the x direction
+ * @param ry    radius in the y direction
+ * @param phi   angle with respect to x-axis
+ *
+ * @return      array holding center (x,y), starting angle and extend angle
+ */
+std::array<double,4> Svg2Cairo::Path::endpoint_to_center(double x1, double y1, double x2, double y2,
+                                                        double fa, double fs, double rx, double ry,
+                                                        double phi) {
+
+        // Compute the half distance between the current and the final point
+        double dx2 = (x1 - x2) / 2.0;
+        double dy2 = (y1 - y2) / 2.0;
+
+        // calculate the angles
+        double cos_angle = std::cos(phi);
+        double sin_angle = std::sin(phi);
+
+        //
+        // Step 1 : Compute (x1p, y1p)
+        //
+        double x1p = (cos_angle * dx2 + sin_angle * dy2);
+        double y1p = (-sin_angle * dx2 + cos_angle * dy2);
+
+        // ensure radii are large enough
+        rx = std::fabs(rx);
         ry = std::fabs(ry);
         double Prx = rx * rx;
         double Pry = ry * ry;
@@ -446,81 +1302,1123 @@ std::array<double,4> Svg2Cairo::Path::endpoint_to_center(double x1, double y1, d
 }
 
 /*****************************************************************
- * SVG2CAIRO CLASS
+ * SVG2CAIRO GROUP CLASS
  *****************************************************************/
 
-Svg2Cairo::Svg2Cairo::Svg2Cairo(const std::string& filename) {
-    boost::property_tree::read_xml(filename, this->pt);
-
-    auto children = this->pt.get_child("svg");
-    for(const auto& v : children) {
-        if(v.first == "circle") {
-            const double cx = v.second.get<double>("<xmlattr>.cx");
-            const double cy = v.second.get<double>("<xmlattr>.cy");
-            const double radius = v.second.get<double>("<xmlattr>.r");
-
-            std::string style;
-            try {
-                style = v.second.get<std::string>("<xmlattr>.style");
-            } catch(const std::exception& e) {
-                // do nothing
-            }
+Svg2Cairo::Group::Group(std::pmr::memory_resource* resource) : Shape(SHAPE_GROUP), children(resource) {}
 
-            std::string transform;
-            try {
-                transform = v.second.get<std::string>("<xmlattr>.transform");
-            } catch(const std::exception& e) {
-                // do nothing
-            }
+/*
+ * @fn create_path
+ *
+ * @brief construct the outlines of all children as the current Cairo path
+ *
+ * @param cr pointer to cairo object
+ *
+ */
+void Svg2Cairo::Group::create_path(cairo_t* cr) const {
+    for(const auto& child : this->children) {
+        cairo_save(cr);
+        child->handle_transform(cr);
+        child->create_path(cr);
+        cairo_restore(cr);
+    }
+}
 
-            auto circle = new Circle(cx, cy, radius);
-            auto shape = reinterpret_cast<Shape*>(circle);
-            this->find_transformations(shape, transform, style);
+/*
+ * @fn update_bounds
+ *
+ * @brief calculate the bounding box from the children of the group
+ *
+ */
+void Svg2Cairo::Group::update_bounds() {
+    this->bounds = BoundingBox();
 
-            this->shapes.emplace_back(shape);
-        }
+    for(const auto& child : this->children) {
+        cairo_matrix_t m;
+        child->get_transform(&m);
+        this->bounds.add(transform_bounds(m, child->get_bounds()));
+    }
+}
 
-        if(v.first =="path") {
-            const std::string d = v.second.get<std::string>("<xmlattr>.d");
+/*****************************************************************
+ * SVG2CAIRO USE CLASS
+ *****************************************************************/
 
-            std::string transform;
-            try {
-                transform = v.second.get<std::string>("<xmlattr>.transform");
-            } catch(const std::exception& e) {
-                // do nothing
-            }
+Svg2Cairo::Use::Use(double _x, double _y) : Shape(SHAPE_USE), reference(nullptr), x(_x), y(_y) {}
 
-            std::string style;
-            try {
-                style = v.second.get<std::string>("<xmlattr>.style");
-            } catch(const std::exception& e) {
-                // do nothing
-            }
+/*
+ * @fn create_path
+ *
+ * @brief construct the outline of the referenced shape as the current Cairo path
+ *
+ * @param cr pointer to cairo object
+ *
+ */
+void Svg2Cairo::Use::create_path(cairo_t* cr) const {
+    if(this->reference == nullptr) {
+        return;
+    }
 
-            auto path = new Path(d);
-            auto shape = reinterpret_cast<Shape*>(path);
-            this->find_transformations(shape, transform, style);
+    cairo_save(cr);
+    this->handle_offset(cr);
+    this->reference->handle_transform(cr);
+    this->reference->create_path(cr);
+    cairo_restore(cr);
+}
 
-            this->shapes.emplace_back(shape);
-        }
+/*
+ * @fn update_bounds
+ *
+ * @brief calculate the bounding box from the referenced shape
+ *
+ */
+void Svg2Cairo::Use::update_bounds() {
+    this->bounds = BoundingBox();
+    if(this->reference == nullptr) {
+        return;
     }
+
+    cairo_matrix_t m, offset;
+    this->reference->get_transform(&m);
+    cairo_matrix_init_translate(&offset, this->x, this->y);
+    cairo_matrix_multiply(&m, &m, &offset);
+    this->bounds = transform_bounds(m, this->reference->get_bounds());
 }
 
-void Svg2Cairo::Svg2Cairo::draw(cairo_t* cr) {
-    for(auto shape : this->shapes) {
-        cairo_save(cr);
-        shape->handle_transform(cr);
-        shape->draw(cr);
+/*****************************************************************
+ * SVG2CAIRO CLASS
+ *****************************************************************/
 
-        // back transform at end of shape
-        cairo_restore(cr);
+Svg2Cairo::Svg2Cairo::Svg2Cairo(const LoadOptions& options) :
+    arena(options.upstream), root(&this->arena), defs(&this->arena), shapes(&this->arena), ids(&this->arena),
+    patterns(&this->arena), sprites(&this->arena) {}
+
+Svg2Cairo::Svg2Cairo::Svg2Cairo(const std::string& filename, const LoadOptions& options) : Svg2Cairo(options) {
+    boost::property_tree::read_xml(filename, this->pt);
+    this->load(options);
+}
+
+Svg2Cairo::Svg2Cairo::Svg2Cairo(std::istream& stream, const LoadOptions& options) : Svg2Cairo(options) {
+    boost::property_tree::read_xml(stream, this->pt);
+    this->load(options);
+}
+
+void Svg2Cairo::Svg2Cairo::load(const LoadOptions& options) {
+    unsigned int nr_threads = options.nr_threads;
+    if(nr_threads == 0) {
+        nr_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    LoadContext ctx;
+    ctx.deferred = nr_threads > 1;
+    ctx.lazy = options.lazy;
+    ctx.coordinates = options.coordinates;
+    this->load_children(this->pt.get_child("svg"), this->root, ctx, true);
+    if(ctx.deferred) {
+        this->convert_deferred(ctx, nr_threads);
+    }
+    this->resolve_references(ctx);
+
+    // lazy paths compile from the XML tree; otherwise it is no longer needed
+    if(!options.lazy) {
+        this->pt.clear();
+    }
+
+    if(options.cache_paint) {
+        this->cache_patterns();
+    }
+}
+
+Svg2Cairo::Svg2Cairo::~Svg2Cairo() {
+    for(const auto& pattern : this->patterns) {
+        cairo_pattern_destroy(pattern.second);
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::draw(cairo_t* cr, const RenderOptions& options) const {
+    this->draw_all(cr, nullptr, options, nullptr);
+}
+
+void Svg2Cairo::Svg2Cairo::draw(cairo_t* cr, const FrameParameters& params, const RenderOptions& options) const {
+    this->draw_all(cr, &params, options, nullptr);
+}
+
+bool Svg2Cairo::Svg2Cairo::draw(cairo_t* cr, const RenderOptions& options, const CancellationToken& token) const {
+    return this->draw_all(cr, nullptr, options, &token);
+}
+
+bool Svg2Cairo::Svg2Cairo::draw_all(cairo_t* cr, const FrameParameters* params, const RenderOptions& options, const CancellationToken* token) const {
+    DrawState state = this->begin_draw(cr, params, options, token);
+
+    const Color paint;
+    for(const auto& child : this->root.get_children()) {
+        this->draw_shape(cr, *child, paint, 255, state);
+    }
+
+    cairo_restore(cr);
+    return !state.interrupted;
+}
+
+bool Svg2Cairo::Svg2Cairo::draw(cairo_t* cr, DrawCursor& cursor, std::chrono::steady_clock::duration budget, const RenderOptions& options) const {
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+
+    BoundingBox clip;
+    cairo_matrix_t m;
+    cairo_get_matrix(cr, &m);
+    cairo_clip_extents(cr, &clip.x1, &clip.y1, &clip.x2, &clip.y2);
+    clip = transform_bounds(m, clip);
+    if(!cursor.matches(this, m, clip)) {
+        this->start_cursor(cursor, m, clip);
+    }
+
+    if(cursor.pass == DrawCursor::PASS_COLLECT) {
+        const DrawState state = {nullptr, options, clip, device_scale(cr), false, 0, nullptr, false};
+        if(!this->collect_items(cr, cursor, state, deadline)) {
+            return false;
+        }
+        this->start_preview(cr, cursor);
+    }
+
+    // the deadline is checked between shapes, after the first one
+    size_t nr_drawn = 0;
+    auto expired = [&]() {
+        return nr_drawn > 0 && std::chrono::steady_clock::now() >= deadline;
+    };
+
+    if(cursor.pass == DrawCursor::PASS_PREVIEW) {
+        const RenderOptions preview = RenderOptions::preview();
+        cairo_save(cr);
+        cairo_set_antialias(cr, preview.antialias);
+        cairo_set_tolerance(cr, preview.tolerance);
+        DrawState state = {nullptr, preview, clip, device_scale(cr), false, 0, nullptr, false};
+
+        auto previewed_after = [&cursor](uint32_t a, uint32_t b) {
+            return cursor.previewed_after(a, b);
+        };
+        while(cursor.position < cursor.order.size() && !expired()) {
+            // the next item moves from the top of the heap to the sorted part at the back
+            std::pop_heap(cursor.order.begin(), cursor.order.end() - cursor.position, previewed_after);
+            const DrawCursor::Item& item = cursor.items[cursor.order[cursor.order.size() - ++cursor.position]];
+            if(std::max(item.box.width(), item.box.height()) * state.device_scale >= preview.cull_size) {
+                this->draw_item(cr, item, 0.0, 0.0, state);
+                nr_drawn++;
+            }
+        }
+        cairo_restore(cr);
+
+        if(cursor.position == cursor.order.size()) {
+            cursor.pass = DrawCursor::PASS_REFINE;
+            cursor.position = 0;
+        }
+    }
+
+    if(cursor.pass == DrawCursor::PASS_REFINE) {
+        // the refined image is built on the copy of the canvas, hidden behind the preview until it is complete
+        cairo_t* target = cursor.layer ? cairo_create(cursor.layer.get()) : cr;
+        cairo_save(target);
+        cairo_set_antialias(target, options.antialias);
+        cairo_set_tolerance(target, options.tolerance);
+        DrawState state = {nullptr, options, clip, device_scale(cr), false, 0, nullptr, false};
+        const double dx = cursor.layer ? cursor.x0 : 0.0;
+        const double dy = cursor.layer ? cursor.y0 : 0.0;
+
+        while(cursor.position < cursor.items.size() && !expired()) {
+            this->draw_item(target, cursor.items[cursor.position++], dx, dy, state);
+            nr_drawn++;
+        }
+        cairo_restore(target);
+
+        if(cursor.layer) {
+            cairo_destroy(target);
+        }
+
+        if(cursor.position == cursor.items.size()) {
+            if(cursor.layer) {
+                cairo_save(cr);
+                cairo_identity_matrix(cr);
+                cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+                cairo_set_source_surface(cr, cursor.layer.get(), cursor.x0, cursor.y0);
+                cairo_paint(cr);
+                cairo_restore(cr);
+                cursor.layer.reset();
+            }
+            cursor.pass = DrawCursor::PASS_DONE;
+        }
+    }
+
+    return cursor.pass == DrawCursor::PASS_DONE;
+}
+
+void Svg2Cairo::Svg2Cairo::start_cursor(DrawCursor& cursor, const cairo_matrix_t& matrix, const BoundingBox& clip) const {
+    cursor.reset();
+    cursor.document = this;
+    cursor.matrix = matrix;
+    cursor.clip = clip;
+    cursor.items.reserve(this->get_nr_shapes());
+    cursor.order.reserve(this->get_nr_shapes());
+    cursor.pending.push_back(DrawCursor::Frame{&this->root, 0, matrix, Color(), 255});
+}
+
+bool Svg2Cairo::Svg2Cairo::collect_items(cairo_t* cr, DrawCursor& cursor, const DrawState& state,
+                                         std::chrono::steady_clock::time_point deadline) const {
+    cairo_save(cr);
+
+    // depth-first over the pending groups and instances, such that a later call can continue
+    size_t nr_visited = 0;
+    while(!cursor.pending.empty()) {
+        if(++nr_visited % COLLECT_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+
+        DrawCursor::Frame& frame = cursor.pending.back();
+        const Shape* shape = nullptr;
+        if(frame.shape->get_type() == SHAPE_GROUP) {
+            const auto& children = static_cast<const Group*>(frame.shape)->get_children();
+            if(frame.next < children.size()) {
+                shape = children[frame.next].get();
+            }
+        } else if(frame.next == 0) {
+            shape = static_cast<const Use*>(frame.shape)->get_reference();
+        }
+
+        if(shape == nullptr) {
+            cursor.pending.pop_back();
+            continue;
+        }
+        frame.next++;
+
+        cairo_set_matrix(cr, &frame.matrix);
+        shape->handle_transform(cr);
+
+        cairo_matrix_t m;
+        cairo_get_matrix(cr, &m);
+        const BoundingBox box = transform_bounds(m, shape->get_bounds());
+        if(!this->is_visible(box, state)) {
+            continue;
+        }
+
+        const Color color = shape->get_fill(frame.paint);
+        const unsigned int fill_opacity = shape->get_fill_opacity(frame.opacity);
+
+        if(shape->get_type() == SHAPE_GROUP) {
+            cursor.pending.push_back(DrawCursor::Frame{shape, 0, m, color, fill_opacity});
+        } else if(shape->get_type() == SHAPE_USE) {
+            const Use& use = static_cast<const Use&>(*shape);
+            if(use.get_reference() != nullptr) {
+                use.handle_offset(cr);
+                cairo_get_matrix(cr, &m);
+                cursor.pending.push_back(DrawCursor::Frame{shape, 0, m, color, fill_opacity});
+            }
+        } else {
+            const Color fill = color.with_opacity(fill_opacity);
+            if(fill.get_rgba() & 0xFF) {
+                // the preview order is kept as a heap, such that no sort is needed once all shapes are known
+                cursor.items.push_back(DrawCursor::Item{shape, m, fill, box});
+                cursor.order.push_back(static_cast<uint32_t>(cursor.items.size() - 1));
+                std::push_heap(cursor.order.begin(), cursor.order.end(), [&cursor](uint32_t a, uint32_t b) {
+                    return cursor.previewed_after(a, b);
+                });
+            }
+        }
+    }
+
+    cairo_restore(cr);
+    return cursor.pending.empty();
+}
+
+void Svg2Cairo::Svg2Cairo::start_preview(cairo_t* cr, DrawCursor& cursor) const {
+    // without a copy of the canvas (e.g. for an unbounded or very large canvas) the preview is
+    // skipped, as the final image drawn on the canvas would be composited over it
+    cursor.pass = DrawCursor::PASS_REFINE;
+    cursor.position = 0;
+
+    // copy the visible part of the canvas, onto which the final image is drawn
+    cairo_surface_t* canvas = cairo_get_group_target(cr);
+    double x1 = std::floor(std::max(cursor.clip.x1, -1e6));
+    double y1 = std::floor(std::max(cursor.clip.y1, -1e6));
+    double x2 = std::ceil(std::min(cursor.clip.x2, 1e6));
+    double y2 = std::ceil(std::min(cursor.clip.y2, 1e6));
+    if(cairo_surface_get_type(canvas) == CAIRO_SURFACE_TYPE_IMAGE) {
+        x1 = std::max(x1, 0.0);
+        y1 = std::max(y1, 0.0);
+        x2 = std::min(x2, static_cast<double>(cairo_image_surface_get_width(canvas)));
+        y2 = std::min(y2, static_cast<double>(cairo_image_surface_get_height(canvas)));
+    }
+    if(cursor.items.empty() || x2 <= x1 || y2 <= y1 || (x2 - x1) * (y2 - y1) > MAX_LAYER_PIXELS) {
+        return;
+    }
+
+    cairo_surface_t* layer = cairo_surface_create_similar(canvas, cairo_surface_get_content(canvas),
+                                                          static_cast<int>(x2 - x1), static_cast<int>(y2 - y1));
+    if(cairo_surface_status(layer) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(layer);
+        return;
+    }
+
+    cursor.x0 = static_cast<int>(x1);
+    cursor.y0 = static_cast<int>(y1);
+    cairo_t* copy = cairo_create(layer);
+    cairo_set_operator(copy, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(copy, canvas, -x1, -y1);
+    cairo_paint(copy);
+    cairo_destroy(copy);
+    cursor.layer = std::shared_ptr<cairo_surface_t>(layer, cairo_surface_destroy);
+    cursor.pass = DrawCursor::PASS_PREVIEW;
+}
+
+void Svg2Cairo::Svg2Cairo::draw_item(cairo_t* cr, const DrawCursor::Item& item, double dx, double dy, DrawState& state) const {
+    cairo_matrix_t m = item.matrix;
+    m.x0 -= dx;
+    m.y0 -= dy;
+    cairo_set_matrix(cr, &m);
+
+    this->set_source(cr, item.fill, state);
+    if(!this->draw_sprite(cr, *item.shape, m, state)) {
+        item.shape->fill(cr, state.options.lod_tolerance);
+    }
+}
+
+Svg2Cairo::Svg2Cairo::DrawState Svg2Cairo::Svg2Cairo::begin_draw(cairo_t* cr, const FrameParameters* params,
+                                                                  const RenderOptions& options, const CancellationToken* token) const {
+    cairo_save(cr);
+    cairo_set_antialias(cr, options.antialias);
+    cairo_set_tolerance(cr, options.tolerance);
+
+    // establish the visible region in device space once, such that every shape can be tested against it
+    BoundingBox clip;
+    cairo_matrix_t m;
+    cairo_get_matrix(cr, &m);
+    cairo_clip_extents(cr, &clip.x1, &clip.y1, &clip.x2, &clip.y2);
+    return DrawState{params, options, transform_bounds(m, clip), device_scale(cr), false, 0, token, false};
+}
+
+size_t Svg2Cairo::Svg2Cairo::render_stream(std::istream& stream, cairo_t* cr, const RenderOptions& options, const LoadOptions& load_options) {
+    // the document only holds the definitions; streamed shapes come from a pool and return to it once drawn
+    Svg2Cairo doc(load_options);
+    std::pmr::synchronized_pool_resource pool(load_options.upstream != nullptr ? load_options.upstream : std::pmr::get_default_resource());
+
+    LoadContext ctx;
+    ctx.deferred = false;
+    ctx.lazy = false;
+    ctx.coordinates = load_options.coordinates;
+
+    XmlStreamReader reader(stream);
+    DrawState state = doc.begin_draw(cr, nullptr, options, nullptr);
+    std::vector<StreamFrame> stack = {{Color(), 255, false, 0}};
+    size_t nr_drawn = 0;
+
+    auto draw = [&](StreamItem&& item) {
+        if(item.kind == StreamItem::STREAM_SHAPE) {
+            nr_drawn++;
+        }
+        doc.draw_streamed(cr, item, stack, state);
+        return true;
+    };
+
+    try {
+        if(load_options.nr_threads == 1) {
+            doc.read_stream(reader, ctx, &pool, draw);
+        } else {
+            // read ahead on a separate thread; the cairo object is only used by this thread
+            StreamChannel<StreamItem> channel(STREAM_QUEUE_DEPTH);
+            std::exception_ptr error;
+            std::thread producer([&]() {
+                try {
+                    doc.read_stream(reader, ctx, &pool, [&channel](StreamItem&& item) {
+                        return channel.push(std::move(item));
+                    });
+                } catch(...) {
+                    error = std::current_exception();
+                }
+                channel.close();
+            });
+
+            try {
+                StreamItem item;
+                while(channel.pop(item)) {
+                    draw(std::move(item));
+                    item.shape.reset();     // release the shape before waiting for the next one
+                }
+            } catch(...) {
+                channel.abort();
+                producer.join();
+                throw;
+            }
+            producer.join();
+            if(error) {
+                std::rethrow_exception(error);
+            }
+        }
+    } catch(...) {
+        // undo the groups that remain open after an error
+        for(size_t i=1; i<stack.size(); i++) {
+            cairo_restore(cr);
+        }
+        cairo_restore(cr);
+        throw;
+    }
+
+    cairo_restore(cr);
+    return nr_drawn;
+}
+
+void Svg2Cairo::Svg2Cairo::read_stream(XmlStreamReader& reader, LoadContext& ctx, std::pmr::memory_resource* resource,
+                                       const std::function<bool(StreamItem&&)>& sink) {
+    // the root element must be <svg>, as for a document loaded at once
+    XmlStreamReader::Event event = reader.next();
+    if(event != XmlStreamReader::XML_START || reader.get_name() != "svg") {
+        throw boost::property_tree::ptree_bad_path("No such node", boost::property_tree::ptree::path_type("svg"));
+    }
+
+    std::unordered_map<const Shape*, int> visited;  // shapes of which the bounds are final
+    std::unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)> surface(
+        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1), &cairo_surface_destroy);
+    std::unique_ptr<cairo_t, decltype(&cairo_destroy)> scratch(cairo_create(surface.get()), &cairo_destroy);
+    cairo_set_tolerance(scratch.get(), RETAIN_TOLERANCE);
+
+    while(true) {
+        event = reader.next();
+        if(event == XmlStreamReader::XML_EOF || reader.get_depth() == 0) {
+            return;     // end of the root element
+        }
+
+        if(event == XmlStreamReader::XML_END) {
+            // only the ends of groups are reported; other elements are read completely below
+            if(!sink(StreamItem{StreamItem::STREAM_END_GROUP, nullptr})) {
+                return;
+            }
+            continue;
+        }
+
+        const std::string& name = reader.get_name();
+        const boost::property_tree::ptree& node = reader.get_node();
+
+        if(name == "g") {
+            auto group = std::allocate_shared<Group>(std::pmr::polymorphic_allocator<Group>(resource), resource);
+            this->convert_attributes(group.get(), node, false);
+            if(!sink(StreamItem{StreamItem::STREAM_BEGIN_GROUP, group})) {
+                return;
+            }
+            continue;
+        }
+
+        if(name == "defs" || name == "symbol") {
+            // definitions are kept in the document, loaded as a whole
+            boost::property_tree::ptree wrapper;
+            boost::property_tree::ptree& element = wrapper.push_back(std::make_pair(name, node))->second;
+            reader.read_element(element);
+
+            const size_t first = this->defs.get_children().size();
+            this->load_children(wrapper, this->defs, ctx, false);
+            for(const auto& use : ctx.uses) {
+                auto it = this->ids.find(std::pmr::string(use.second.data(), use.second.size()));
+                if(it != this->ids.end()) {
+                    use.first->set_reference(it->second);
+                } else {
+                    std::cerr << "Unknown reference: #" << use.second << " encountered." << std::endl;
+                }
+            }
+            ctx.uses.clear();
+
+            // earlier definitions may be in use by the drawing side, so only the new ones are completed;
+            // their outlines are retained up front since instances are drawn right away
+            for(size_t i=first; i<this->defs.get_children().size(); i++) {
+                Shape& shape = *this->defs.get_children()[i];
+                this->update_bounds(shape, visited);
+                this->retain_paths(scratch.get(), shape);
+            }
+            continue;
+        }
+
+        std::shared_ptr<Shape> shape = this->create_shape(name, node, ctx, resource);
+        if(shape) {
+            this->convert_attributes(shape.get(), node, false);
+        }
+        reader.skip_element();  // children of shapes and of unsupported elements are not drawn
+
+        if(shape && shape->get_type() == SHAPE_USE) {
+            Use* use = static_cast<Use*>(shape.get());
+            const std::string& href = ctx.uses.back().second;
+            auto it = this->ids.find(std::pmr::string(href.data(), href.size()));
+            if(it != this->ids.end()) {
+                use->set_reference(it->second);
+                use->update_bounds();
+            } else {
+                std::cerr << "Unknown reference: #" << href << " encountered." << std::endl;
+                shape.reset();
+            }
+            ctx.uses.clear();
+        }
+
+        if(shape && !sink(StreamItem{StreamItem::STREAM_SHAPE, shape})) {
+            return;
+        }
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::draw_streamed(cairo_t* cr, const StreamItem& item, std::vector<StreamFrame>& stack, DrawState& state) const {
+    switch(item.kind) {
+        case StreamItem::STREAM_SHAPE:
+            this->draw_shape(cr, *item.shape, stack.back().paint, stack.back().opacity, state);
+        break;
+        case StreamItem::STREAM_BEGIN_GROUP: {
+            // mirrors draw_shape for a group, of which the children arrive one by one
+            const StreamFrame& parent = stack.back();
+            StreamFrame frame = {item.shape->get_fill(parent.paint), item.shape->get_fill_opacity(parent.opacity),
+                                 state.has_source, state.source};
+            cairo_save(cr);
+            item.shape->handle_transform(cr);
+            stack.push_back(frame);
+        }
+        break;
+        case StreamItem::STREAM_END_GROUP:
+            cairo_restore(cr);
+            state.has_source = stack.back().has_source;
+            state.source = stack.back().source;
+            stack.pop_back();
+        break;
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::draw_shape(cairo_t* cr, const Shape& shape, const Color& paint, unsigned int opacity, DrawState& state) const {
+    if(state.token != nullptr && state.token->is_cancelled()) {
+        state.interrupted = true;
+        return;
+    }
+
+    const ShapeParameters* sp = nullptr;
+    if(state.params != nullptr && shape.get_type() != SHAPE_GROUP) {
+        sp = state.params->get(shape.get_index());
+    }
+
+    // a single shape only changes the transformation; by keeping the remainder of the
+    // graphics state, consecutive shapes of the same color share the cairo source
+    const bool leaf = shape.get_type() != SHAPE_GROUP && shape.get_type() != SHAPE_USE;
+    cairo_matrix_t saved_matrix;
+    const bool saved_has_source = state.has_source;
+    const uint32_t saved_source = state.source;
+    if(leaf) {
+        cairo_get_matrix(cr, &saved_matrix);
+    } else {
+        cairo_save(cr);
+    }
+
+    shape.handle_transform(cr);
+
+    if(sp != nullptr && sp->has_transform) {
+        cairo_transform(cr, &sp->transform);
+    }
+
+    // skip shapes (or complete groups) that lie outside the clip region or are too small to be visible;
+    // the bounds of groups and instances ignore per-frame transforms of their descendants, which
+    // may move these anywhere, so with frame parameters only single shapes are tested
+    cairo_matrix_t m;
+    cairo_get_matrix(cr, &m);
+    if((!leaf && state.params != nullptr) || this->is_visible(transform_bounds(m, shape.get_bounds()), state)) {
+        const Color& color = (sp != nullptr && sp->has_color) ? sp->color : shape.get_fill(paint);
+        const unsigned int fill_opacity = shape.get_fill_opacity(opacity);
+
+        if(shape.get_type() == SHAPE_GROUP) {
+            for(const auto& child : static_cast<const Group&>(shape).get_children()) {
+                this->draw_shape(cr, *child, color, fill_opacity, state);
+            }
+        } else if(shape.get_type() == SHAPE_USE) {
+            const Use& use = static_cast<const Use&>(shape);
+            if(use.get_reference() != nullptr) {
+                use.handle_offset(cr);
+                this->draw_shape(cr, *use.get_reference(), color, fill_opacity, state);
+            }
+        } else {
+            const Color fill = color.with_opacity(fill_opacity);
+            if(fill.get_rgba() & 0xFF) {    // fully transparent fills (e.g. fill: none) are skipped
+                this->set_source(cr, fill, state);
+                if(!this->draw_sprite(cr, shape, m, state)) {
+                    shape.fill(cr, state.options.lod_tolerance);
+                }
+            }
+        }
+    }
+
+    // back transform at end of shape
+    if(leaf) {
+        cairo_set_matrix(cr, &saved_matrix);
+    } else {
+        cairo_restore(cr);
+        state.has_source = saved_has_source;
+        state.source = saved_source;
+    }
+}
+
+std::vector<size_t> Svg2Cairo::Svg2Cairo::find_shapes_at(double x, double y) const {
+    const HitIndex& index = this->get_hit_index();
+
+    BoundingBox region;
+    region.add(x, y);
+    std::vector<uint32_t> candidates;
+    index.bvh.query(region, [&candidates](uint32_t i) {
+        candidates.push_back(i);
+    });
+
+    // topmost shapes first; a shape is reported once, even when several of its instanced parts cover the point
+    std::sort(candidates.begin(), candidates.end(), [&index](uint32_t a, uint32_t b) {
+        return index.items[a].owner > index.items[b].owner ||
+               (index.items[a].owner == index.items[b].owner && a < b);
+    });
+
+    std::vector<size_t> found;
+    if(candidates.empty()) {
+        return found;
+    }
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+    auto cr = cairo_create(surface);
+    for(uint32_t i : candidates) {
+        const HitItem& item = index.items[i];
+        if(!found.empty() && found.back() == item.owner) {
+            continue;
+        }
+        if(this->in_fill(cr, item, x, y)) {
+            found.push_back(item.owner);
+        }
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+
+    return found;
+}
+
+std::vector<size_t> Svg2Cairo::Svg2Cairo::find_shapes_in(const BoundingBox& region, bool contained) const {
+    const HitIndex& index = this->get_hit_index();
+
+    std::vector<size_t> found;
+    index.bvh.query(region, [&](uint32_t i) {
+        found.push_back(index.items[i].owner);
+    });
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    if(contained) {
+        found.erase(std::remove_if(found.begin(), found.end(), [&](size_t idx) {
+            const BoundingBox& box = index.owner_bounds[idx];
+            return box.x1 < region.x1 || box.y1 < region.y1 || box.x2 > region.x2 || box.y2 > region.y2;
+        }), found.end());
+    }
+
+    return found;
+}
+
+std::string Svg2Cairo::Svg2Cairo::get_shape_id(size_t idx) const {
+    const HitIndex& index = this->get_hit_index();
+    return idx < index.shape_ids.size() ? index.shape_ids[idx] : std::string();
+}
+
+const Svg2Cairo::Svg2Cairo::HitIndex& Svg2Cairo::Svg2Cairo::get_hit_index() const {
+    std::call_once(this->hit_index_built, [this]() {
+        auto index = std::make_unique<HitIndex>();
+        std::vector<BoundingBox> bounds;
+
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        auto cr = cairo_create(surface);
+        const Color paint;
+        for(const auto& child : this->root.get_children()) {
+            this->collect_hits(cr, *child, UINT32_MAX, paint, 255, *index, bounds);
+        }
+        cairo_destroy(cr);
+        cairo_surface_destroy(surface);
+
+        index->owner_bounds.resize(this->shapes.size());
+        for(size_t i=0; i<index->items.size(); i++) {
+            index->owner_bounds[index->items[i].owner].add(bounds[i]);
+        }
+        index->bvh.build(std::move(bounds));
+
+        index->shape_ids.resize(this->shapes.size());
+        for(const auto& id : this->ids) {
+            const size_t idx = id.second->get_index();
+            if(idx < this->shapes.size() && this->shapes[idx].get() == id.second) {
+                index->shape_ids[idx].assign(id.first.data(), id.first.size());
+            }
+        }
+
+        this->hit_index = std::move(index);
+    });
+
+    return *this->hit_index;
+}
+
+void Svg2Cairo::Svg2Cairo::collect_hits(cairo_t* cr, const Shape& shape, uint32_t owner, const Color& paint, unsigned int opacity,
+                                        HitIndex& index, std::vector<BoundingBox>& bounds) const {
+    if(owner == UINT32_MAX && shape.get_type() != SHAPE_GROUP) {
+        owner = static_cast<uint32_t>(shape.get_index());
+    }
+
+    cairo_matrix_t saved_matrix;
+    cairo_get_matrix(cr, &saved_matrix);
+    shape.handle_transform(cr);
+
+    const Color color = shape.get_fill(paint);
+    const unsigned int fill_opacity = shape.get_fill_opacity(opacity);
+
+    if(shape.get_type() == SHAPE_GROUP) {
+        for(const auto& child : static_cast<const Group&>(shape).get_children()) {
+            this->collect_hits(cr, *child, owner, color, fill_opacity, index, bounds);
+        }
+    } else if(shape.get_type() == SHAPE_USE) {
+        const Use& use = static_cast<const Use&>(shape);
+        if(use.get_reference() != nullptr) {
+            use.handle_offset(cr);
+            this->collect_hits(cr, *use.get_reference(), owner, color, fill_opacity, index, bounds);
+        }
+    } else if(color.with_opacity(fill_opacity).get_rgba() & 0xFF) {
+        HitItem item;
+        item.shape = &shape;
+        item.owner = owner;
+        cairo_get_matrix(cr, &item.matrix);
+        index.items.push_back(item);
+        bounds.push_back(transform_bounds(item.matrix, shape.get_bounds()));
+    }
+
+    cairo_set_matrix(cr, &saved_matrix);
+}
+
+bool Svg2Cairo::Svg2Cairo::in_fill(cairo_t* cr, const HitItem& item, double x, double y) const {
+    // the outline is constructed in document space, in which the point is given
+    cairo_new_path(cr);
+    cairo_set_matrix(cr, &item.matrix);
+    item.shape->create_path(cr);
+    cairo_identity_matrix(cr);
+    return cairo_in_fill(cr, x, y);
+}
+
+bool Svg2Cairo::Svg2Cairo::is_visible(const BoundingBox& box, const DrawState& state) const {
+    bool visible = !box.empty() &&
+                   box.x1 <= state.clip.x2 && box.x2 >= state.clip.x1 &&
+                   box.y1 <= state.clip.y2 && box.y2 >= state.clip.y1;
+    if(state.options.cull_size > 0.0) {
+        visible = visible && std::max(box.width(), box.height()) * state.device_scale >= state.options.cull_size;
+    }
+    return visible;
+}
+
+void Svg2Cairo::Svg2Cairo::set_source(cairo_t* cr, const Color& color, DrawState& state) const {
+    const uint32_t rgba = color.get_rgba();
+    if(state.has_source && state.source == rgba) {
+        return;
+    }
+
+    auto it = this->patterns.find(rgba);
+    if(it != this->patterns.end()) {
+        cairo_set_source(cr, it->second);
+    } else if(color.is_opaque()) {
+        cairo_set_source_rgb(cr, color.get_r(), color.get_g(), color.get_b());
+    } else {
+        cairo_set_source_rgba(cr, color.get_r(), color.get_g(), color.get_b(), color.get_a());
+    }
+
+    state.has_source = true;
+    state.source = rgba;
+}
+
+bool Svg2Cairo::Svg2Cairo::draw_sprite(cairo_t* cr, const Shape& shape, const cairo_matrix_t& m, const DrawState& state) const {
+    if(shape.get_type() != SHAPE_CIRCLE || state.options.sprite_radius <= 0.0) {
+        return false;
+    }
+
+    // a sprite is a bitmap, which would replace the outline on vector surfaces
+    cairo_surface_t* target = cairo_get_target(cr);
+    if(cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return false;
+    }
+
+    // pixels per device unit, which must not stretch the circle either
+    double ds, dsy;
+    cairo_surface_get_device_scale(target, &ds, &dsy);
+    if(ds != dsy || !(ds > 0.0)) {
+        return false;
+    }
+
+    // the circle stays a circle under rotation and uniform scaling only
+    const double scale = std::sqrt(std::fabs(m.xx * m.yy - m.xy * m.yx));
+    const double eps = 1e-9 * std::max(1.0, scale);
+    if(std::fabs(m.xx - m.yy) > eps || std::fabs(m.yx + m.xy) > eps) {
+        return false;
+    }
+
+    double cx, cy, r;
+    static_cast<const CircleShape&>(shape).get_geometry(&cx, &cy, &r);
+    const double radius = std::fabs(r) * scale * ds;
+    if(radius >= std::min(state.options.sprite_radius, SpriteCache::SPRITE_MAX_RADIUS)) {
+        return false;
+    }
+
+    // the sprite is made and placed in pixels of the target, which differ from device units by the device scale
+    cairo_matrix_transform_point(&m, &cx, &cy);
+    this->sprites.draw(cr, cx * ds, cy * ds, radius, ds, state.options.antialias);
+    return true;
+}
+
+void Svg2Cairo::Svg2Cairo::cache_patterns() {
+    std::vector<uint32_t> colors = {Color().get_rgba()};
+    std::vector<unsigned int> opacities = {255};
+    this->collect_paints(this->root, colors, opacities);
+    this->collect_paints(this->defs, colors, opacities);
+
+    std::sort(colors.begin(), colors.end());
+    colors.erase(std::unique(colors.begin(), colors.end()), colors.end());
+    std::sort(opacities.begin(), opacities.end());
+    opacities.erase(std::unique(opacities.begin(), opacities.end()), opacities.end());
+
+    // colors and opacities are inherited independently, so any combination can occur; paints
+    // beyond the limit (as well as colors set per frame) are set without a cached pattern
+    for(uint32_t rgba : colors) {
+        for(unsigned int opacity : opacities) {
+            if(this->patterns.size() >= MAX_CACHED_PATTERNS) {
+                return;
+            }
+
+            const Color color = Color::from_rgba(rgba).with_opacity(opacity);
+            if(this->patterns.count(color.get_rgba()) != 0) {
+                continue;
+            }
+
+            cairo_pattern_t* pattern = color.is_opaque() ?
+                cairo_pattern_create_rgb(color.get_r(), color.get_g(), color.get_b()) :
+                cairo_pattern_create_rgba(color.get_r(), color.get_g(), color.get_b(), color.get_a());
+            this->patterns.emplace(color.get_rgba(), pattern);
+        }
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::collect_paints(const Shape& shape, std::vector<uint32_t>& colors, std::vector<unsigned int>& opacities) const {
+    if(shape.is_color_set()) {
+        colors.push_back(shape.get_color().get_rgba());
+    }
+    if(shape.is_fill_opacity_set()) {
+        opacities.push_back(shape.get_fill_opacity(255));
+    }
+
+    if(shape.get_type() == SHAPE_GROUP) {
+        for(const auto& child : static_cast<const Group&>(shape).get_children()) {
+            this->collect_paints(*child, colors, opacities);
+        }
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::load_children(const boost::property_tree::ptree& node, Group& parent, LoadContext& ctx, bool indexed) {
+    for(const auto& v : node) {
+        std::shared_ptr<Shape> shape = this->create_shape(v.first, v.second, ctx, &this->arena);
+        bool definition = false;    // shape is only drawn when referenced
+
+        if(v.first == "g") {
+            auto group = std::allocate_shared<Group>(std::pmr::polymorphic_allocator<Group>(&this->arena), &this->arena);
+            this->load_children(v.second, *group, ctx, indexed);
+
+            shape = group;
+        }
+
+        if(v.first == "defs") {
+            this->load_children(v.second, this->defs, ctx, false);
+            continue;
+        }
+
+        if(v.first == "symbol") {
+            auto group = std::allocate_shared<Group>(std::pmr::polymorphic_allocator<Group>(&this->arena), &this->arena);
+            this->load_children(v.second, *group, ctx, false);
+
+            shape = group;
+            definition = true;
+        }
+
+        if(!shape) {
+            continue;
+        }
+
+        if(ctx.deferred) {
+            ctx.elements.emplace_back(shape.get(), &v.second);
+        } else {
+            this->convert_attributes(shape.get(), v.second, ctx.lazy);
+        }
+
+        const auto id = v.second.get_child_optional("<xmlattr>.id");
+        if(id && !id->data().empty()) {
+            this->ids[std::pmr::string(id->data().data(), id->data().size())] = shape.get();
+        }
+
+        if(definition) {
+            this->defs.add_child(shape);
+            continue;
+        }
+
+        if(indexed && shape->get_type() != SHAPE_GROUP) {
+            shape->set_index(this->shapes.size());
+            this->shapes.push_back(shape);
+        }
+        parent.add_child(shape);
+    }
+}
+
+std::shared_ptr<Svg2Cairo::Shape> Svg2Cairo::Svg2Cairo::create_shape(const std::string& name, const boost::property_tree::ptree& node,
+                                                                   LoadContext& ctx, std::pmr::memory_resource* resource) const {
+    if(name == "circle") {
+        const double cx = node.get<double>("<xmlattr>.cx");
+        const double cy = node.get<double>("<xmlattr>.cy");
+        const double radius = node.get<double>("<xmlattr>.r");
+
+        if(ctx.coordinates == COORDINATES_DOUBLE) {
+            return std::allocate_shared<Circle>(std::pmr::polymorphic_allocator<Circle>(resource), cx, cy, radius);
+        }
+        // a quantized format does not pay off for three values
+        return std::allocate_shared<BasicCircle<float> >(std::pmr::polymorphic_allocator<BasicCircle<float> >(resource), cx, cy, radius);
+    }
+
+    if(name == "path") {
+        return std::allocate_shared<Path>(std::pmr::polymorphic_allocator<Path>(resource), resource, ctx.coordinates);
+    }
+
+    if(name == "use") {
+        auto use = std::allocate_shared<Use>(std::pmr::polymorphic_allocator<Use>(resource),
+                                             node.get<double>("<xmlattr>.x", 0.0),
+                                             node.get<double>("<xmlattr>.y", 0.0));
+
+        std::string href = node.get<std::string>("<xmlattr>.href",
+                           node.get<std::string>("<xmlattr>.xlink:href", ""));
+        if(!href.empty() && href[0] == '#') {
+            href = href.substr(1);
+        }
+        ctx.uses.emplace_back(use.get(), href);
+        return use;
+    }
+
+    return nullptr;
+}
+
+void Svg2Cairo::Svg2Cairo::convert_attributes(Shape* shape, const boost::property_tree::ptree& node, bool lazy) const {
+    if(shape->get_type() == SHAPE_PATH) {
+        Path* path = static_cast<Path*>(shape);
+        if(lazy) {
+            // the XML tree outlives the path and serves as its source
+            path->defer(&node.get_child("<xmlattr>.d").data());
+        } else {
+            path->compile(node.get_child("<xmlattr>.d").data());
+        }
+    }
+
+    // refer to the attribute strings in the XML tree instead of copying them
+    static const std::string empty;
+    const auto transform = node.get_child_optional("<xmlattr>.transform");
+    const auto style = node.get_child_optional("<xmlattr>.style");
+
+    // presentation attributes are overridden by the style
+    for(const char* key : {"<xmlattr>.fill", "<xmlattr>.fill-opacity"}) {
+        const auto attribute = node.get_child_optional(key);
+        if(attribute) {
+            const std::string& value = attribute->data();
+            apply_fill_property(shape, key + std::strlen("<xmlattr>."), trim(value.data(), value.data() + value.size()));
+        }
+    }
+
+    this->find_transformations(shape, transform ? transform->data() : empty, style ? style->data() : empty);
+}
+
+void Svg2Cairo::Svg2Cairo::convert_deferred(LoadContext& ctx, unsigned int nr_threads) const {
+    WorkerPool pool(nr_threads);
+
+    // every element is converted independently; use a few chunks per thread to balance the load
+    const size_t nr_elements = ctx.elements.size();
+    const size_t chunk = std::max<size_t>(64, nr_elements / (4 * nr_threads) + 1);
+
+    std::vector<std::future<void> > results;
+    for(size_t start=0; start<nr_elements; start+=chunk) {
+        const size_t stop = std::min(nr_elements, start + chunk);
+        results.push_back(pool.submit([this, &ctx, start, stop]() {
+            for(size_t i=start; i<stop; i++) {
+                this->convert_attributes(ctx.elements[i].first, *ctx.elements[i].second, ctx.lazy);
+            }
+        }));
+    }
+
+    // wait for all chunks, rethrowing the first error encountered
+    for(auto& result : results) {
+        result.wait();
+    }
+    for(auto& result : results) {
+        result.get();
+    }
+}
+
+void Svg2Cairo::Svg2Cairo::resolve_references(LoadContext& ctx) {
+    for(const auto& use : ctx.uses) {
+        auto it = this->ids.find(std::pmr::string(use.second.data(), use.second.size()));
+        if(it != this->ids.end()) {
+            use.first->set_reference(it->second);
+        } else {
+            std::cerr << "Unknown reference: #" << use.second << " encountered." << std::endl;
+        }
+    }
+
+    // bounding boxes of instances depend on the shapes they refer to, which may be defined later on
+    std::unordered_map<const Shape*, int> visited;
+    this->update_bounds(this->defs, visited);
+    this->update_bounds(this->root, visited);
+
+    // keep the outlines of all instanced shapes, such that they are constructed only once
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    auto cr = cairo_create(surface);
+    cairo_set_tolerance(cr, RETAIN_TOLERANCE);
+    for(const auto& use : ctx.uses) {
+        if(use.first->get_reference() != nullptr) {
+            this->retain_paths(cr, *use.first->get_reference());
+        }
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+}
+
+void Svg2Cairo::Svg2Cairo::update_bounds(Shape& shape, std::unordered_map<const Shape*, int>& visited) {
+    int& state = visited[&shape];
+    if(state == 2) {
+        return;
+    }
+    state = 1;
+
+    if(shape.get_type() == SHAPE_GROUP) {
+        Group& group = static_cast<Group&>(shape);
+        for(const auto& child : group.get_children()) {
+            this->update_bounds(*child, visited);
+        }
+        group.update_bounds();
+    } else if(shape.get_type() == SHAPE_USE) {
+        Use& use = static_cast<Use&>(shape);
+        if(use.get_reference() != nullptr) {
+            if(visited[use.get_reference()] == 1) {
+                // the instance refers to one of its ancestors, which can never be drawn
+                std::cerr << "Circular reference encountered." << std::endl;
+                use.set_reference(nullptr);
+            } else {
+                this->update_bounds(*use.get_reference(), visited);
+            }
+        }
+        use.update_bounds();
+    }
+
+    visited[&shape] = 2;
+}
+
+void Svg2Cairo::Svg2Cairo::retain_paths(cairo_t* cr, Shape& shape) {
+    if(shape.get_type() == SHAPE_GROUP) {
+        for(const auto& child : static_cast<Group&>(shape).get_children()) {
+            this->retain_paths(cr, *child);
+        }
+    } else if(shape.get_type() == SHAPE_USE) {
+        // nested instances are handled via their own entry in the list of instances
+    } else {
+        shape.retain_path(cr);
     }
 }
 
-void Svg2Cairo::Svg2Cairo::find_transformations(Shape* shape, const std::string& transform, const std::string& style) {
-    static const boost::regex regex_translate(".*translate\\(([0-9.-]+) ([0-9.-]+)\\).*");
+void Svg2Cairo::Svg2Cairo::find_transformations(Shape* shape, const std::string& transform, const std::string& style) const {
+    static const boost::regex regex_translate(".*translate\\(([0-9.-]+)[ ,]+([0-9.-]+)\\).*");
     static const boost::regex regex_rotate(".*rotate\\(([0-9.-]+)\\).*");
-    static const boost::regex regex_fill_color(".*fill:\\s*#([a-fA-F0-9]+).*");
 
     boost::smatch what;
     if(boost::regex_match(transform, what, regex_translate)) {
@@ -534,11 +2432,15 @@ void Svg2Cairo::Svg2Cairo::find_transformations(Shape* shape, const std::string&
         shape->set_rotate(angle);
     }
 
-    if(boost::regex_match(style, what, regex_fill_color)) {
-        std::string hex = what[1];
-        if(hex.length() == 3) {
-            hex = hex[0] + std::string("f") + hex[1] + std::string("f") + hex[2] + std::string("f");
+    // style declarations (name: value; ...)
+    const char* p = style.data();
+    const char* end = p + style.size();
+    while(p != end) {
+        const char* stop = std::find(p, end, ';');
+        const char* colon = std::find(p, stop, ':');
+        if(colon != stop) {
+            apply_fill_property(shape, trim(p, colon), trim(colon + 1, stop));
         }
-        shape->set_color(Color(hex));
+        p = (stop == end) ? end : stop + 1;
     }
 }
@@ -39,16 +39,48 @@
 #include <cairo.h>
 #include <cmath>
 #include <array>
+#include <unordered_map>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <memory_resource>
+#include <istream>
+#include <functional>
+#include <chrono>
 
 #include "color.h"
+#include "geometry.h"
+#include "render_options.h"
+#include "load_options.h"
+#include "arena.h"
+#include "coordinate_store.h"
+#include "sprite_cache.h"
+#include "cancellation.h"
+#include "xml_stream.h"
+#include "progressive.h"
+#include "shape_index.h"
 
 namespace Svg2Cairo {
 
 enum {
     SHAPE_CIRCLE,
-    SHAPE_PATH
+    SHAPE_PATH,
+    SHAPE_GROUP,
+    SHAPE_USE
 };
 
+enum {
+    PATH_MOVE_TO,       // x, y
+    PATH_LINE_TO,       // x, y
+    PATH_CURVE_TO,      // x1, y1, x2, y2, x3, y3
+    PATH_ARC,           // cx, cy, phi, rx, ry, angle1, angle2
+    PATH_CLOSE          // (no coordinates)
+};
+
+class FrameParameters;
+struct ShapeParameters;
+
 /*****************************************************************
  * CAIRO TRANSLATE OPERATION
  *****************************************************************/
@@ -84,7 +116,17 @@ public:
      * @param cr pointer to cairo object
      *
      */
-    void draw(cairo_t* cr);
+    void draw(cairo_t* cr) const;
+
+    /*
+     * @fn apply
+     *
+     * @brief perform translation on a transformation matrix
+     *
+     * @param m pointer to matrix
+     *
+     */
+    void apply(cairo_matrix_t* m) const;
 
 };
 
@@ -121,7 +163,17 @@ public:
      * @param cr pointer to cairo object
      *
      */
-    void draw(cairo_t* cr);
+    void draw(cairo_t* cr) const;
+
+    /*
+     * @fn apply
+     *
+     * @brief perform rotation on a transformation matrix
+     *
+     * @param m pointer to matrix
+     *
+     */
+    void apply(cairo_matrix_t* m) const;
 
 private:
 };
@@ -139,31 +191,195 @@ private:
 class Shape {
 private:
     unsigned int type;                          //!< type of the shape
-    std::unique_ptr<Translate> translate;       //!< unique pointer to translate operation
-    std::unique_ptr<Rotate> rotate;             //!< unique pointer to rotate operation
+    size_t index;                               //!< position of the shape in the document
+    std::optional<Translate> translate;         //!< translate operation (stored inline)
+    std::optional<Rotate> rotate;               //!< rotate operation (stored inline)
     Color color;                                //!< color of the shape (uses external color object)
+    bool has_color;                             //!< whether the color is set (otherwise it is inherited)
+    unsigned char fill_opacity;                 //!< opacity (0-255) applied to the fill color
+    bool has_fill_opacity;                      //!< whether the opacity is set (otherwise it is inherited)
+    cairo_path_t* retained_path;                //!< outline kept as cairo path for shapes that are instanced
+
+protected:
+    BoundingBox bounds;                         //!< bounding box in the shape's own coordinate system
 
 public:
     Shape(unsigned int _type);
 
+    virtual ~Shape();
+
+    Shape(const Shape&) = delete;
+    Shape& operator=(const Shape&) = delete;
+
     inline void set_translate(double x, double y) {
-        this->translate = std::make_unique<Translate>(x, y);
+        this->translate.emplace(x, y);
     }
 
     inline void set_rotate(double angle) {
-        this->rotate = std::make_unique<Rotate>(angle);
+        this->rotate.emplace(angle);
     }
 
     inline void set_color(const Color& _color) {
         this->color = _color;
+        this->has_color = true;
+    }
+
+    inline const Color& get_color() const {
+        return this->color;
+    }
+
+    inline bool is_color_set() const {
+        return this->has_color;
+    }
+
+    inline bool is_fill_opacity_set() const {
+        return this->has_fill_opacity;
+    }
+
+    /*
+     * @fn get_fill
+     *
+     * @brief get the color to fill the shape with
+     *
+     * @param inherited color of the enclosing group
+     *
+     * @return own color if set, otherwise the inherited color
+     */
+    inline const Color& get_fill(const Color& inherited) const {
+        return this->has_color ? this->color : inherited;
+    }
+
+    inline void set_fill_opacity(unsigned int _opacity) {
+        this->fill_opacity = std::min(_opacity, 255u);
+        this->has_fill_opacity = true;
+    }
+
+    /*
+     * @fn get_fill_opacity
+     *
+     * @brief get the opacity of the fill
+     *
+     * The opacity is inherited separately from the color, and multiplies
+     * the alpha of the fill color when drawing.
+     *
+     * @param inherited opacity of the enclosing group (0-255)
+     *
+     * @return own opacity if set, otherwise the inherited opacity
+     */
+    inline unsigned int get_fill_opacity(unsigned int inherited) const {
+        return this->has_fill_opacity ? this->fill_opacity : inherited;
+    }
+
+    inline unsigned int get_type() const {
+        return this->type;
+    }
+
+    inline void set_index(size_t _index) {
+        this->index = _index;
+    }
+
+    inline size_t get_index() const {
+        return this->index;
+    }
+
+    inline const BoundingBox& get_bounds() const {
+        return this->bounds;
     }
 
-    virtual void draw(cairo_t* cr) = 0;
+    /*
+     * @fn draw
+     *
+     * @brief fill the shape on the Cairo canvas using its own color
+     *
+     * @param cr pointer to cairo object
+     *
+     */
+    void draw(cairo_t* cr) const;
+
+    /*
+     * @fn draw
+     *
+     * @brief fill the shape on the Cairo canvas using a specific color
+     *
+     * @param cr        pointer to cairo object
+     * @param _color    color to fill the shape with
+     *
+     */
+    void draw(cairo_t* cr, const Color& _color) const;
+
+    /*
+     * @fn draw
+     *
+     * @brief fill the shape on the Cairo canvas using a simplified outline
+     *
+     * @param cr        pointer to cairo object
+     * @param _color    color to fill the shape with
+     * @param tolerance maximum deviation of the outline in device pixels
+     *
+     */
+    void draw(cairo_t* cr, const Color& _color, double tolerance) const;
+
+    /*
+     * @fn fill
+     *
+     * @brief fill the shape on the Cairo canvas using the current source
+     *
+     * @param cr        pointer to cairo object
+     * @param tolerance maximum deviation of the outline in device pixels
+     *
+     */
+    void fill(cairo_t* cr, double tolerance) const;
+
+    /*
+     * @fn create_path
+     *
+     * @brief construct the outline of the shape as the current Cairo path
+     *
+     * @param cr pointer to cairo object
+     *
+     */
+    virtual void create_path(cairo_t* cr) const = 0;
+
+    /*
+     * @fn create_path
+     *
+     * @brief construct a simplified outline of the shape as the current Cairo path
+     *
+     * Shapes that do not support simplification construct their exact outline.
+     *
+     * @param cr        pointer to cairo object
+     * @param tolerance maximum deviation of the outline in device pixels
+     *
+     */
+    virtual void create_path(cairo_t* cr, double tolerance) const;
+
+    void handle_transform(cairo_t* cr) const;
+
+    /*
+     * @fn retain_path
+     *
+     * @brief store the outline of the shape as cairo path
+     *
+     * Shapes that are referenced many times (via <use>) are drawn by
+     * appending the stored path, rather than by constructing it again.
+     *
+     * @param cr pointer to cairo object used to construct the path
+     *
+     */
+    void retain_path(cairo_t* cr);
 
-    void handle_transform(cairo_t* cr);
+    /*
+     * @fn get_transform
+     *
+     * @brief get the transformation of the shape with respect to its parent
+     *
+     * @param m pointer to matrix receiving the transformation
+     *
+     */
+    void get_transform(cairo_matrix_t* m) const;
 
 protected:
-    void cairo_set_color(cairo_t* cr);
+    void cairo_set_color(cairo_t* cr, const Color& _color) const;
 
 };
 
@@ -172,25 +388,63 @@ protected:
  *****************************************************************/
 
 /*
- * @class Circle
+ * @class CircleShape
+ *
+ * @brief interface of SVG circles, independent of the storage of their geometry
+ *
+ */
+class CircleShape : public Shape {
+public:
+    CircleShape() : Shape(SHAPE_CIRCLE) {}
+
+    /*
+     * @fn get_geometry
+     *
+     * @brief get the center and radius of the circle
+     *
+     */
+    virtual void get_geometry(double* _cx, double* _cy, double* _r) const = 0;
+};
+
+/*
+ * @class BasicCircle
  *
  * @brief Object that holds an SVG Circle
  *
+ * The center and radius are stored as T: double, or float when the
+ * document uses compact coordinate storage (see CoordinateStorage).
+ *
  */
-class Circle : public Shape {
+template<typename T>
+class BasicCircle : public CircleShape {
 private:
-    double cx;
-    double cy;
-    double r;
+    T cx;
+    T cy;
+    T r;
 
 public:
-    Circle(double _cx, double _cy, double _r);
+    BasicCircle(double _cx, double _cy, double _r) :
+        cx((T)_cx), cy((T)_cy), r((T)_r) {
+        // enclose the circle as it is drawn, i.e. using the stored values
+        this->bounds.add(this->cx - std::fabs(this->r), this->cy - std::fabs(this->r));
+        this->bounds.add(this->cx + std::fabs(this->r), this->cy + std::fabs(this->r));
+    }
 
-    void draw(cairo_t* cr);
+    using Shape::create_path;
 
-private:
+    void create_path(cairo_t* cr) const {
+        cairo_arc(cr, this->cx, this->cy, this->r, 0.0, 2 * M_PI);
+    }
+
+    void get_geometry(double* _cx, double* _cy, double* _r) const {
+        *_cx = this->cx;
+        *_cy = this->cy;
+        *_r = this->r;
+    }
 };
 
+typedef BasicCircle<double> Circle;
+
 /*****************************************************************
  * SVG2CAIRO PATH CLASS
  *****************************************************************/
@@ -203,42 +457,279 @@ private:
  */
 class Path : public Shape {
 private:
-    std::string operations;
-    char operand;
-    std::string coordinates;
+    /*
+     * @class PathData
+     *
+     * @brief compiled representation of a path
+     *
+     * Points (end and control points, arc centers) are kept apart from
+     * the remaining arc parameters (rotation, radii and angles), such that
+     * the points can be stored in a compact format.
+     *
+     */
+    struct PathData {
+        std::pmr::vector<unsigned char> commands;   //!< compiled path commands (see PATH_* enum)
+        CoordinateStore points;                     //!< points belonging to the compiled commands
+        std::pmr::vector<double> params;            //!< rotation, radii and angles of the arcs
+
+        PathData(std::pmr::memory_resource* resource, CoordinateStorage format) :
+            commands(resource), points(resource, format), params(resource) {}
+    };
+
+    /*
+     * @class PathBuffer
+     *
+     * @brief growable scratch storage receiving compiled commands
+     *
+     */
+    struct PathBuffer {
+        std::vector<unsigned char> commands;        //!< compiled path commands (see PATH_* enum)
+        std::vector<double> points;                 //!< points belonging to the compiled commands
+        std::vector<double> params;                 //!< rotation, radii and angles of the arcs
+
+        inline void clear() {
+            this->commands.clear();
+            this->points.clear();
+            this->params.clear();
+        }
+    };
+
+    PathData data;                              //!< exact path (empty until first use for lazy paths)
+    const std::string* source;                  //!< path data of a lazy path (owned by the document)
+    mutable std::once_flag compiled;            //!< guards the compilation of a lazy path
+    mutable std::pmr::vector<std::pair<int, PathData*> > variants;  //!< simplified variants per scale bucket (nullptr: use the exact path)
 
 public:
+    /*
+     * @fn Path
+     *
+     * @brief construct an empty path (see compile and defer)
+     *
+     * @param resource memory resource holding the compiled data
+     * @param format   storage of the compiled coordinates
+     *
+     */
+    Path(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+         CoordinateStorage format = COORDINATES_DOUBLE);
+
+    virtual ~Path();
+
     /*
      * @fn Path
      *
      * @brief default constructor
      *
      * @param _operations string holding all operations (grabbed from XML)
+     * @param resource    memory resource holding the compiled data
+     * @param format      storage of the compiled coordinates
      *
      */
-    Path(const std::string& _operations);
+    Path(const std::string& _operations,
+         std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+         CoordinateStorage format = COORDINATES_DOUBLE);
 
     /*
-     * @fn draw
+     * @fn compile
+     *
+     * @brief convert the string of SVG operations into compiled commands
+     *
+     * @param _operations string holding all operations (grabbed from XML)
+     *
+     */
+    void compile(const std::string& _operations);
+
+    /*
+     * @fn defer
+     *
+     * @brief postpone compilation of the path until it is first drawn
+     *
+     * Only a (conservative) bounding box is estimated, without converting
+     * arcs or storing commands; the string is kept by reference
+     * and needs to outlive the path. Compilation on first use is thread-safe.
+     *
+     * @param _source string holding all operations (grabbed from XML)
+     *
+     */
+    void defer(const std::string* _source);
+
+    /*
+     * @fn create_path
      *
-     * @brief draw the path on the Cairo canvas
+     * @brief replay the compiled path on the Cairo canvas
      *
      * @param cr                pointer to cairo object
      *
      */
-    void draw(cairo_t* cr);
+    void create_path(cairo_t* cr) const;
+
+    /*
+     * @fn create_path
+     *
+     * @brief replay a simplified variant of the path on the Cairo canvas
+     *
+     * Curves and arcs are flattened and the resulting polylines decimated
+     * such that the outline deviates less than the tolerance in device
+     * space under the current transformation. Variants are cached per
+     * power-of-two bucket of the scaling factor of the transformation.
+     *
+     * @param cr                pointer to cairo object
+     * @param tolerance         maximum deviation in device pixels
+     *
+     */
+    void create_path(cairo_t* cr, double tolerance) const;
 
 private:
     /*
-     * @fn perform_operation
+     * @fn ensure_compiled
      *
-     * @brief perform user-space rotation on cairo object
+     * @brief compile a lazy path if this has not happened yet
+     *
+     */
+    void ensure_compiled() const;
+
+    /*
+     * @fn replay
+     *
+     * @brief construct compiled path data as the current Cairo path
      *
      * @param cr                pointer to cairo object
+     * @param pd                compiled path data
+     *
+     */
+    static void replay(cairo_t* cr, const PathData& pd);
+
+    /*
+     * @fn simplify
+     *
+     * @brief build a flattened and decimated variant of the path
+     *
+     * @param tolerance         maximum deviation in user space
+     *
+     * @return simplified path data (nullptr if it is not smaller than the exact path)
+     */
+    PathData* simplify(double tolerance) const;
+
+    /*
+     * @fn store
+     *
+     * @brief copy compiled data into exactly sized storage
+     *
+     * @param dest              path data receiving the copy
+     * @param src               scratch path data
+     *
+     */
+    static void store(PathData& dest, const PathBuffer& src);
+
+    /*
+     * @class PathCompiler
+     *
+     * @brief state used while converting the SVG path operations into
+     *        compiled commands
+     *
+     * Cairo keeps track of the current point while a path is being built;
+     * because the path is now compiled only once, the compiler mirrors
+     * that bookkeeping so that relative instructions can be resolved to
+     * absolute coordinates.
+     *
+     */
+    struct PathCompiler {
+        PathBuffer* pd = nullptr;   //!< receives the commands (none: only estimate the bounding box)
+        BoundingBox box;            //!< bounding box of the commands (complete once build returns)
+        char operand = '\0';        //!< operand currently being collected
+        bool quiet = false;         //!< suppress warnings (already reported during loading)
+        std::vector<double> coord;  //!< coordinates belonging to the operand
+        bool has_point = false;     //!< whether a current point exists
+        double x = 0.0;             //!< current point x
+        double y = 0.0;             //!< current point y
+        double sx = 0.0;            //!< start of current subpath x
+        double sy = 0.0;            //!< start of current subpath y
+    };
+
+    /*
+     * @fn build
+     *
+     * @brief run the compiler over a string of SVG operations
+     *
+     * @param _operations       string holding all operations
+     * @param pc                compiler state
+     *
+     */
+    static void build(const std::string& _operations, PathCompiler& pc);
+
+    /*
+     * @fn tokenize
+     *
+     * @brief convert a range of the operation string to coordinates
+     *
+     * @param pc                compiler state receiving the coordinates
+     * @param begin             start of the range
+     * @param end               end of the range
+     *
+     */
+    static void tokenize(PathCompiler& pc, const char* begin, const char* end);
+
+    /*
+     * @fn perform_operation
+     *
+     * @brief compile the current operand into path commands
+     *
+     * @param pc                compiler state
      * @param char new_operand  char specifying the next instruction for the path
      *
      */
-    void perform_operation(cairo_t* cr, char new_operand);
+    static void perform_operation(PathCompiler& pc, char new_operand);
+
+    /*
+     * @fn move_to
+     *
+     * @brief add a move_to command to the compiled path
+     */
+    static void move_to(PathCompiler& pc, double x, double y);
+
+    /*
+     * @fn line_to
+     *
+     * @brief add a line_to command to the compiled path
+     */
+    static void line_to(PathCompiler& pc, double x, double y);
+
+    /*
+     * @fn curve_to
+     *
+     * @brief add a curve_to command to the compiled path
+     */
+    static void curve_to(PathCompiler& pc, double x1, double y1, double x2, double y2, double x3, double y3);
+
+    /*
+     * @fn arc_to
+     *
+     * @brief add an (elliptical) arc command to the compiled path
+     *
+     * @param pc    compiler state
+     * @param x2    end point x
+     * @param y2    end point y
+     * @param coord arc parameters (rx, ry, phi, fa, fs) as given in the SVG
+     */
+    static void arc_to(PathCompiler& pc, double x2, double y2, const std::vector<double>& coord);
+
+    /*
+     * @fn estimate_arc
+     *
+     * @brief bound an (elliptical) arc and advance the current point without converting it
+     *
+     * @param pc    compiler state
+     * @param x2    end point x
+     * @param y2    end point y
+     * @param coord arc parameters (rx, ry, phi, fa, fs) as given in the SVG
+     */
+    static void estimate_arc(PathCompiler& pc, double x2, double y2, const std::vector<double>& coord);
+
+    /*
+     * @fn close_path
+     *
+     * @brief add a close_path command to the compiled path
+     */
+    static void close_path(PathCompiler& pc);
 
     /*
      * @fn endpoint_to_center
@@ -264,25 +755,776 @@ private:
      *
      * @return      array holding center (x,y), starting angle and extend angle
      */
-    std::array<double,4> endpoint_to_center(double x1, double y1, double x2, double y2, double fa, double fs, double rx, double ry, double phi);
+    static std::array<double,4> endpoint_to_center(double x1, double y1, double x2, double y2, double fa, double fs, double rx, double ry, double phi);
 };
 
 /*****************************************************************
- * SVG2CAIRO CLASS
+ * SVG2CAIRO GROUP CLASS
  *****************************************************************/
 
-class Svg2Cairo {
+/*
+ * @class Group
+ *
+ * @brief Object that holds an SVG group (<g>)
+ *
+ * Children inherit the transformation and the fill color of the group.
+ * The bounding box of a group encloses the (transformed) bounding boxes
+ * of all its children, such that a complete subtree can be rejected
+ * with a single test.
+ *
+ */
+class Group : public Shape {
 private:
-    boost::property_tree::ptree pt;
-    std::vector<std::shared_ptr<Shape> > shapes;
+    std::pmr::vector<std::shared_ptr<Shape> > children; //!< shapes in this group
 
 public:
-    Svg2Cairo(const std::string& filename);
+    /*
+     * @fn Group
+     *
+     * @brief Group constructor
+     *
+     * @param resource memory resource holding the list of children
+     *
+     */
+    Group(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-    void draw(cairo_t* cr);
+    inline void add_child(const std::shared_ptr<Shape>& child) {
+        this->children.push_back(child);
+    }
 
-private:
-    void find_transformations(Shape* shape, const std::string& transform, const std::string& style);
+    inline const std::pmr::vector<std::shared_ptr<Shape> >& get_children() const {
+        return this->children;
+    }
+
+    using Shape::create_path;
+
+    /*
+     * @fn create_path
+     *
+     * @brief construct the outlines of all children as the current Cairo path
+     *
+     * @param cr pointer to cairo object
+     *
+     */
+    void create_path(cairo_t* cr) const;
+
+    /*
+     * @fn update_bounds
+     *
+     * @brief calculate the bounding box from the children of the group
+     *
+     * Needs to be called after the children (and their bounding boxes)
+     * are complete.
+     *
+     */
+    void update_bounds();
+};
+
+/*****************************************************************
+ * SVG2CAIRO USE CLASS
+ *****************************************************************/
+
+/*
+ * @class Use
+ *
+ * @brief Object that holds an instance (<use>) of another shape or group
+ *
+ * The referenced shape is shared by all its instances; an instance only
+ * stores its placement and its (optional) fill color, which is
+ * inherited by referenced shapes that do not set their own.
+ *
+ */
+class Use : public Shape {
+private:
+    Shape* reference;   //!< instanced shape (owned by the document)
+    double x;           //!< offset in x direction
+    double y;           //!< offset in y direction
+
+public:
+    Use(double _x, double _y);
+
+    inline void set_reference(Shape* _reference) {
+        this->reference = _reference;
+    }
+
+    inline const Shape* get_reference() const {
+        return this->reference;
+    }
+
+    inline Shape* get_reference() {
+        return this->reference;
+    }
+
+    /*
+     * @fn handle_offset
+     *
+     * @brief position the referenced shape
+     *
+     * @param cr pointer to cairo object
+     *
+     */
+    inline void handle_offset(cairo_t* cr) const {
+        cairo_translate(cr, this->x, this->y);
+    }
+
+    using Shape::create_path;
+
+    /*
+     * @fn create_path
+     *
+     * @brief construct the outline of the referenced shape as the current Cairo path
+     *
+     * @param cr pointer to cairo object
+     *
+     */
+    void create_path(cairo_t* cr) const;
+
+    /*
+     * @fn update_bounds
+     *
+     * @brief calculate the bounding box from the referenced shape
+     *
+     */
+    void update_bounds();
+};
+
+/*****************************************************************
+ * SVG2CAIRO CLASS
+ *****************************************************************/
+
+class Svg2Cairo {
+private:
+    Arena arena;                                    //!< holds all shapes and their data (destroyed last)
+    boost::property_tree::ptree pt;                 //!< XML tree (only retained for lazy paths)
+    Group root;                                     //!< tree of shapes and groups
+    Group defs;                                     //!< contents of <defs> and <symbol>, only drawn via <use>
+    std::pmr::vector<std::shared_ptr<Shape> > shapes;               //!< all shapes (excluding groups) in document order
+    std::pmr::unordered_map<std::pmr::string, Shape*> ids;          //!< shapes by their id attribute
+    std::pmr::unordered_map<uint32_t, cairo_pattern_t*> patterns;   //!< solid patterns for the paints in the document
+    mutable SpriteCache sprites;                    //!< masks of small circles, filled while drawing
+
+    /*
+     * @class HitItem
+     *
+     * @brief filled shape in the hit-test index
+     *
+     */
+    struct HitItem {
+        const Shape* shape;         //!< shape to test (never a group or instance)
+        cairo_matrix_t matrix;      //!< transformation from the shape to document space
+        uint32_t owner;             //!< index of the document shape it belongs to (differs for instanced shapes)
+    };
+
+    /*
+     * @class HitIndex
+     *
+     * @brief spatial index of the document for hit-testing and region queries
+     *
+     */
+    struct HitIndex {
+        ShapeIndex bvh;                             //!< bounds of the items in document space
+        std::vector<HitItem> items;                 //!< filled shapes with their transformation
+        std::vector<BoundingBox> owner_bounds;      //!< bounds by document shape
+        std::vector<std::string> shape_ids;         //!< id attribute by document shape (empty if none)
+    };
+
+    mutable std::once_flag hit_index_built;         //!< guards the construction of the hit-test index
+    mutable std::unique_ptr<HitIndex> hit_index;    //!< built on the first query
+
+    /*
+     * @class DrawState
+     *
+     * @brief settings shared by all shapes of a single draw call
+     *
+     */
+    struct DrawState {
+        const FrameParameters* params;      //!< per-shape overrides (nullptr if none)
+        const RenderOptions& options;       //!< accuracy settings
+        BoundingBox clip;                   //!< clip region in device space
+        double device_scale;                //!< pixels per unit of device space
+        bool has_source;                    //!< whether the cairo source is known to be a solid color
+        uint32_t source;                    //!< packed color of the cairo source
+        const CancellationToken* token;     //!< abandons the draw once cancelled (nullptr if none)
+        bool interrupted;                   //!< set when shapes were skipped because of the token
+    };
+
+    /*
+     * @class LoadContext
+     *
+     * @brief bookkeeping while the document is being loaded
+     *
+     */
+    struct LoadContext {
+        std::vector<std::pair<Use*, std::string> > uses;    //!< instances and the id they refer to
+        std::vector<std::pair<Shape*, const boost::property_tree::ptree*> > elements;   //!< shapes of which the attributes are not yet converted
+        bool deferred;                                      //!< whether the conversion of attributes is deferred
+        bool lazy;                                          //!< whether compiling the path data is postponed until drawing
+        CoordinateStorage coordinates;                      //!< storage of the compiled coordinates
+    };
+
+    /*
+     * @class StreamItem
+     *
+     * @brief element passed from the streaming loader to the drawing side
+     *
+     */
+    struct StreamItem {
+        enum Kind {
+            STREAM_SHAPE,           //!< shape to draw
+            STREAM_BEGIN_GROUP,     //!< group whose children follow (the group holds no children)
+            STREAM_END_GROUP        //!< end of the most recent group
+        };
+        Kind kind;                          //!< type of the item
+        std::shared_ptr<Shape> shape;       //!< shape or group (nullptr for STREAM_END_GROUP)
+    };
+
+    /*
+     * @class StreamFrame
+     *
+     * @brief drawing state of a group that is open while streaming
+     *
+     */
+    struct StreamFrame {
+        Color paint;                        //!< fill color inherited by the children
+        unsigned int opacity;               //!< fill opacity inherited by the children
+        bool has_source;                    //!< cairo source tracking outside the group
+        uint32_t source;                    //!< cairo source outside the group
+    };
+
+public:
+    /*
+     * @fn Svg2Cairo
+     *
+     * @brief load a document from a file
+     *
+     * @param filename  path of the SVG file
+     * @param options   loading settings
+     *
+     */
+    Svg2Cairo(const std::string& filename, const LoadOptions& options = LoadOptions());
+
+    /*
+     * @fn Svg2Cairo
+     *
+     * @brief load a document from a stream (e.g. an in-memory buffer)
+     *
+     * @param stream    stream holding the SVG data
+     * @param options   loading settings
+     *
+     */
+    Svg2Cairo(std::istream& stream, const LoadOptions& options = LoadOptions());
+
+    ~Svg2Cairo();
+
+    Svg2Cairo(const Svg2Cairo&) = delete;
+    Svg2Cairo& operator=(const Svg2Cairo&) = delete;
+
+    /*
+     * @fn draw
+     *
+     * @brief draw all shapes on the Cairo canvas
+     *
+     * Drawing does not modify the document, so a single document may be
+     * drawn from several threads at once (each using its own cairo object).
+     *
+     * @param cr        pointer to cairo object
+     * @param options   accuracy settings (see RenderOptions presets)
+     *
+     */
+    void draw(cairo_t* cr, const RenderOptions& options = RenderOptions()) const;
+
+    /*
+     * @fn draw
+     *
+     * @brief draw all shapes, applying per-shape transform and color overrides
+     *
+     * @param cr        pointer to cairo object
+     * @param params    overrides for this frame
+     * @param options   accuracy settings (see RenderOptions presets)
+     *
+     */
+    void draw(cairo_t* cr, const FrameParameters& params, const RenderOptions& options = RenderOptions()) const;
+
+    /*
+     * @fn draw
+     *
+     * @brief draw all shapes unless the draw is cancelled
+     *
+     * The token is checked before every shape; once it is cancelled the
+     * remaining shapes are skipped and the canvas holds a partial image.
+     *
+     * @param cr        pointer to cairo object
+     * @param options   accuracy settings (see RenderOptions presets)
+     * @param token     cancellation token
+     *
+     * @return whether all shapes were drawn
+     */
+    bool draw(cairo_t* cr, const RenderOptions& options, const CancellationToken& token) const;
+
+    /*
+     * @fn draw
+     *
+     * @brief draw shapes until a time budget runs out, continuing where the previous call stopped
+     *
+     * The first pass draws the largest shapes first at preview quality; the
+     * second pass refines the image in the background of later calls (see
+     * DrawCursor). The visible shapes are gathered under the same budget
+     * beforehand. Every call makes progress: it gathers some shapes or
+     * draws at least one. The canvas has to be kept between calls.
+     *
+     * @param cr        pointer to cairo object
+     * @param cursor    progress of earlier calls
+     * @param budget    time available for this call
+     * @param options   accuracy settings of the final image
+     *
+     * @return whether the image is complete
+     */
+    bool draw(cairo_t* cr, DrawCursor& cursor, std::chrono::steady_clock::duration budget,
+              const RenderOptions& options = RenderOptions()) const;
+
+    /*
+     * @fn get_nr_shapes
+     *
+     * @brief get the number of shapes in the document
+     *
+     * @return number of shapes
+     */
+    inline size_t get_nr_shapes() const {
+        return this->shapes.size();
+    }
+
+    /*
+     * @fn find_shapes_at
+     *
+     * @brief find the shapes of which the fill covers a point
+     *
+     * Bounds are looked up in a bounding volume hierarchy, built on the first
+     * query, after which the candidates are tested against their outline.
+     * Shapes without a visible fill are not found. A pixel of a canvas is
+     * converted to document space with cairo_device_to_user, using the
+     * transformation the document is drawn with.
+     *
+     * @param x     x coordinate in document space
+     * @param y     y coordinate in document space
+     *
+     * @return shape indices, topmost first
+     */
+    std::vector<size_t> find_shapes_at(double x, double y) const;
+
+    /*
+     * @fn find_shapes_in
+     *
+     * @brief find the shapes that lie in a rectangle
+     *
+     * Shapes are compared by their bounds in document space.
+     *
+     * @param region        rectangle in document space
+     * @param contained     only report shapes that lie completely within the rectangle
+     *
+     * @return shape indices in document order
+     */
+    std::vector<size_t> find_shapes_in(const BoundingBox& region, bool contained = false) const;
+
+    /*
+     * @fn get_shape_id
+     *
+     * @brief get the id attribute of a shape
+     *
+     * @param idx   shape index
+     *
+     * @return id, or an empty string when the shape has none
+     */
+    std::string get_shape_id(size_t idx) const;
+
+    /*
+     * @fn get_bytes_used
+     *
+     * @brief get the memory occupied by the shapes and their compiled data
+     *
+     * Outlines of instanced shapes (owned by Cairo) and the XML tree kept
+     * for lazy paths are not included.
+     *
+     * @return number of bytes
+     */
+    inline size_t get_bytes_used() const {
+        return this->arena.get_bytes_allocated();
+    }
+
+    /*
+     * @fn get_bytes_reserved
+     *
+     * @brief get the memory held by the document's arena
+     *
+     * This includes the unused remainder of the most recent block and is
+     * the resident footprint of the document.
+     *
+     * @return number of bytes
+     */
+    inline size_t get_bytes_reserved() const {
+        return this->arena.get_bytes_reserved();
+    }
+
+    /*
+     * @fn render_stream
+     *
+     * @brief draw a document while it is being read, without retaining its shapes
+     *
+     * Every shape is drawn as soon as it has been read and released
+     * afterwards, so memory use does not grow with the size of the
+     * document. Only the contents of <defs> and <symbol> are kept, and
+     * instances (<use>) can only refer to definitions read before them.
+     * Groups are not culled as a whole, because their extent is unknown
+     * until their end; their shapes are culled individually.
+     *
+     * With more than one thread in the load options, reading and drawing
+     * overlap: a thread reads the document ahead of the drawing (calling)
+     * thread, by at most a fixed number of elements.
+     *
+     * @param stream        stream holding the SVG data
+     * @param cr            pointer to cairo object
+     * @param options       accuracy settings
+     * @param load_options  loading settings (lazy and cache_paint do not apply)
+     *
+     * @return number of shapes drawn (excluding groups)
+     */
+    static size_t render_stream(std::istream& stream, cairo_t* cr,
+                                const RenderOptions& options = RenderOptions(),
+                                const LoadOptions& load_options = LoadOptions());
+
+private:
+    /*
+     * @fn Svg2Cairo
+     *
+     * @brief set up the (empty) containers of a document
+     *
+     * @param options   loading settings
+     *
+     */
+    Svg2Cairo(const LoadOptions& options);
+
+    /*
+     * @fn load
+     *
+     * @brief construct the shapes from the XML tree
+     *
+     * @param options   loading settings
+     *
+     */
+    void load(const LoadOptions& options);
+
+    /*
+     * @fn draw_all
+     *
+     * @brief draw the complete tree of shapes
+     *
+     * @param cr        pointer to cairo object
+     * @param params    per-shape overrides (nullptr if none)
+     * @param options   accuracy settings
+     * @param token     cancellation token (nullptr if none)
+     *
+     * @return whether all shapes were drawn
+     */
+    bool draw_all(cairo_t* cr, const FrameParameters* params, const RenderOptions& options, const CancellationToken* token) const;
+
+    /*
+     * @fn begin_draw
+     *
+     * @brief save the cairo state and apply the render options
+     *
+     * @param cr        pointer to cairo object
+     * @param params    per-shape overrides (nullptr if none)
+     * @param options   accuracy settings
+     * @param token     cancellation token (nullptr if none)
+     *
+     * @return state of the draw call (restore cr when done)
+     */
+    DrawState begin_draw(cairo_t* cr, const FrameParameters* params, const RenderOptions& options, const CancellationToken* token) const;
+
+    /*
+     * @fn read_stream
+     *
+     * @brief read a document element by element, handing every shape to a sink
+     *
+     * @param reader    XML reader positioned before the root element
+     * @param ctx       load bookkeeping
+     * @param resource  memory resource for the streamed shapes
+     * @param sink      receives the items; returns false to stop reading
+     *
+     */
+    void read_stream(XmlStreamReader& reader, LoadContext& ctx, std::pmr::memory_resource* resource,
+                     const std::function<bool(StreamItem&&)>& sink);
+
+    /*
+     * @fn draw_streamed
+     *
+     * @brief draw an item produced by read_stream
+     *
+     * @param cr        pointer to cairo object
+     * @param item      shape or group boundary
+     * @param stack     open groups
+     * @param state     settings and cairo source of this draw call
+     *
+     */
+    void draw_streamed(cairo_t* cr, const StreamItem& item, std::vector<StreamFrame>& stack, DrawState& state) const;
+
+    /*
+     * @fn draw_shape
+     *
+     * @brief draw a shape or group on the Cairo canvas
+     *
+     * @param cr        pointer to cairo object
+     * @param shape     shape or group to draw
+     * @param paint     fill color inherited from the enclosing group
+     * @param opacity   fill opacity inherited from the enclosing group
+     * @param state     settings and cairo source of this draw call
+     *
+     */
+    void draw_shape(cairo_t* cr, const Shape& shape, const Color& paint, unsigned int opacity, DrawState& state) const;
+
+    /*
+     * @fn set_source
+     *
+     * @brief make a color the cairo source, unless it already is
+     *
+     * @param cr        pointer to cairo object
+     * @param color     fill color
+     * @param state     cairo source of this draw call
+     *
+     */
+    void set_source(cairo_t* cr, const Color& color, DrawState& state) const;
+
+    /*
+     * @fn is_visible
+     *
+     * @brief whether a shape with given bounds has to be drawn
+     *
+     * @param box       bounds of the shape in device space
+     * @param state     clip region and settings of this draw call
+     *
+     * @return false when the shape lies outside the clip region or is too small
+     */
+    bool is_visible(const BoundingBox& box, const DrawState& state) const;
+
+    /*
+     * @fn start_cursor
+     *
+     * @brief (re)initialize a progressive draw of the document
+     *
+     * @param cursor    cursor to (re)initialize
+     * @param matrix    current transformation of the canvas
+     * @param clip      current clip region in device space
+     *
+     */
+    void start_cursor(DrawCursor& cursor, const cairo_matrix_t& matrix, const BoundingBox& clip) const;
+
+    /*
+     * @fn collect_items
+     *
+     * @brief gather the visible shapes of a progressive draw until a deadline
+     *
+     * The deadline is checked every few shapes; a later call continues
+     * with the groups and instances left pending.
+     *
+     * @param cr        pointer to cairo object (used for its transformation)
+     * @param cursor    cursor receiving the shapes
+     * @param state     clip region and settings of the final image
+     * @param deadline  time at which to stop
+     *
+     * @return whether all shapes have been gathered
+     */
+    bool collect_items(cairo_t* cr, DrawCursor& cursor, const DrawState& state,
+                       std::chrono::steady_clock::time_point deadline) const;
+
+    /*
+     * @fn start_preview
+     *
+     * @brief copy the canvas for the refine pass and start the preview pass
+     *
+     * When no copy can be made, the preview is skipped and the refine
+     * pass starts on the canvas itself.
+     *
+     * @param cr        pointer to cairo object
+     * @param cursor    cursor holding all visible shapes
+     *
+     */
+    void start_preview(cairo_t* cr, DrawCursor& cursor) const;
+
+    /*
+     * @fn draw_item
+     *
+     * @brief fill a single shape of a progressive draw
+     *
+     * @param cr        pointer to cairo object
+     * @param item      shape with its transformation and fill
+     * @param dx        device x of the origin of the target
+     * @param dy        device y of the origin of the target
+     * @param state     settings and cairo source of this pass
+     *
+     */
+    void draw_item(cairo_t* cr, const DrawCursor::Item& item, double dx, double dy, DrawState& state) const;
+
+    /*
+     * @fn get_hit_index
+     *
+     * @brief get the hit-test index, building it on first use
+     *
+     * @return index
+     */
+    const HitIndex& get_hit_index() const;
+
+    /*
+     * @fn collect_hits
+     *
+     * @brief add the filled shapes of a shape or group to the hit-test index
+     *
+     * @param cr        pointer to cairo object (used for its transformation)
+     * @param shape     shape or group
+     * @param owner     index of the enclosing document shape (UINT32_MAX at the top level)
+     * @param paint     fill color inherited from the enclosing group
+     * @param opacity   fill opacity inherited from the enclosing group
+     * @param index     index receiving the shapes
+     * @param bounds    bounds of the shapes in document space
+     *
+     */
+    void collect_hits(cairo_t* cr, const Shape& shape, uint32_t owner, const Color& paint, unsigned int opacity,
+                      HitIndex& index, std::vector<BoundingBox>& bounds) const;
+
+    /*
+     * @fn in_fill
+     *
+     * @brief test whether the outline of an indexed shape covers a point
+     *
+     * @param cr        pointer to scratch cairo object
+     * @param item      indexed shape
+     * @param x         x coordinate in document space
+     * @param y         y coordinate in document space
+     *
+     * @return true when the point lies inside the fill
+     */
+    bool in_fill(cairo_t* cr, const HitItem& item, double x, double y) const;
+
+    /*
+     * @fn draw_sprite
+     *
+     * @brief draw a small circle by compositing a cached sprite
+     *
+     * Applies to circles drawn onto image surfaces that remain circles in
+     * device space (i.e. under translation, rotation and uniform scaling)
+     * with a radius in pixels below RenderOptions::sprite_radius. Other
+     * surfaces (e.g. PDF or SVG) keep the vector outline.
+     *
+     * @param cr        pointer to cairo object (transformation is reset)
+     * @param shape     shape to draw
+     * @param m         transformation from the shape to device space
+     * @param state     settings of this draw call
+     *
+     * @return whether the shape was drawn
+     */
+    bool draw_sprite(cairo_t* cr, const Shape& shape, const cairo_matrix_t& m, const DrawState& state) const;
+
+    /*
+     * @fn cache_patterns
+     *
+     * @brief create solid patterns for the paints used in the document
+     *
+     */
+    void cache_patterns();
+
+    /*
+     * @fn collect_paints
+     *
+     * @brief gather the colors and fill opacities set on a shape and its descendants
+     *
+     */
+    void collect_paints(const Shape& shape, std::vector<uint32_t>& colors, std::vector<unsigned int>& opacities) const;
+
+    /*
+     * @fn load_children
+     *
+     * @brief construct the shapes for all children of an XML node
+     *
+     * @param node      XML node
+     * @param parent    group receiving the shapes
+     * @param ctx       load bookkeeping
+     * @param indexed   whether the shapes are drawn as part of the document (i.e. not in <defs>)
+     *
+     */
+    void load_children(const boost::property_tree::ptree& node, Group& parent, LoadContext& ctx, bool indexed);
+
+    /*
+     * @fn create_shape
+     *
+     * @brief construct the shape for a circle, path or use element
+     *
+     * The attributes are not converted. Instances are registered in the
+     * load bookkeeping, to be linked to the shape they refer to.
+     *
+     * @param name      name of the element
+     * @param node      XML node of the element
+     * @param ctx       load bookkeeping
+     * @param resource  memory resource for the shape and its data
+     *
+     * @return shape (nullptr for other elements)
+     */
+    std::shared_ptr<Shape> create_shape(const std::string& name, const boost::property_tree::ptree& node,
+                                        LoadContext& ctx, std::pmr::memory_resource* resource) const;
+
+    /*
+     * @fn convert_attributes
+     *
+     * @brief convert the path data, style and transform of an element
+     *
+     * @param shape     shape constructed for the element
+     * @param node      XML node of the element
+     * @param lazy      only determine the bounds of the path data
+     *
+     */
+    void convert_attributes(Shape* shape, const boost::property_tree::ptree& node, bool lazy) const;
+
+    /*
+     * @fn convert_deferred
+     *
+     * @brief convert the attributes of all deferred elements on a worker pool
+     *
+     * @param ctx           load bookkeeping
+     * @param nr_threads    number of threads
+     *
+     */
+    void convert_deferred(LoadContext& ctx, unsigned int nr_threads) const;
+
+    /*
+     * @fn resolve_references
+     *
+     * @brief link all instances to the shapes they refer to and finalize bounding boxes
+     *
+     * @param ctx       load bookkeeping
+     *
+     */
+    void resolve_references(LoadContext& ctx);
+
+    /*
+     * @fn update_bounds
+     *
+     * @brief calculate the bounding boxes of groups and instances, depth first
+     *
+     * @param shape     shape to update
+     * @param visited   visit state of the shapes (1: in progress, 2: done)
+     *
+     */
+    void update_bounds(Shape& shape, std::unordered_map<const Shape*, int>& visited);
+
+    /*
+     * @fn retain_paths
+     *
+     * @brief store the outlines of an instanced shape (and its children) as cairo paths
+     *
+     * @param cr        pointer to cairo object used to construct the paths
+     * @param shape     instanced shape
+     *
+     */
+    void retain_paths(cairo_t* cr, Shape& shape);
+
+    void find_transformations(Shape* shape, const std::string& transform, const std::string& style) const;
 
 };
 
@@ -0,0 +1,133 @@
+/************************************************************************************
+ *   worker_pool.cpp  --  This file is part of LIBYASVG.                            *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "worker_pool.h"
+
+#include <algorithm>
+
+/*****************************************************************
+ * WORKER POOL
+ *****************************************************************/
+
+/*
+ * @fn WorkerPool
+ *
+ * @brief WorkerPool constructor
+ *
+ * @param nr_threads number of worker threads (0 uses the hardware concurrency)
+ * @param max_queue  maximum number of pending tasks (0: unbounded)
+ *
+ */
+Svg2Cairo::WorkerPool::WorkerPool(unsigned int nr_threads, size_t _max_queue) : max_queue(_max_queue), stopping(false) {
+    if(nr_threads == 0) {
+        nr_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(unsigned int i=0; i<nr_threads; i++) {
+        this->threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+/*
+ * @fn ~WorkerPool
+ *
+ * @brief finish all pending tasks and join the worker threads
+ *
+ */
+Svg2Cairo::WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->stopping = true;
+    }
+    this->cv_task.notify_all();
+
+    for(auto& thread : this->threads) {
+        thread.join();
+    }
+}
+
+/*
+ * @fn enqueue
+ *
+ * @brief place a task in the queue and wake up a worker
+ *
+ * @param task task to execute
+ * @param wait whether to wait for room in a full queue
+ *
+ * @return whether the task was queued
+ */
+bool Svg2Cairo::WorkerPool::enqueue(std::function<void()>&& task, bool wait) {
+    {
+        std::unique_lock<std::mutex> lock(this->mtx);
+        auto has_room = [this]() { return this->max_queue == 0 || this->tasks.size() < this->max_queue; };
+        if(!has_room()) {
+            if(!wait) {
+                return false;
+            }
+            this->cv_space.wait(lock, has_room);
+        }
+        this->tasks.push_back(std::move(task));
+    }
+    this->cv_task.notify_one();
+    return true;
+}
+
+/*
+ * @fn get_nr_pending
+ *
+ * @brief get the number of tasks waiting for a worker
+ *
+ * @return number of tasks
+ */
+size_t Svg2Cairo::WorkerPool::get_nr_pending() {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    return this->tasks.size();
+}
+
+/*
+ * @fn run
+ *
+ * @brief main loop of a worker thread
+ *
+ */
+void Svg2Cairo::WorkerPool::run() {
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->cv_task.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+            if(this->tasks.empty()) {   // only reached when stopping
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+        this->cv_space.notify_one();
+
+        // exceptions are captured by the packaged task
+        task();
+    }
+}
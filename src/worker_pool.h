@@ -0,0 +1,171 @@
+/************************************************************************************
+ *   worker_pool.h  --  This file is part of LIBYASVG.                              *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _WORKER_POOL
+#define _WORKER_POOL
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <optional>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * WORKER POOL
+ *****************************************************************/
+
+/*
+ * @class WorkerPool
+ *
+ * @brief fixed set of threads executing submitted tasks in FIFO order
+ *
+ * The queue of pending tasks may be bounded. A full queue makes submit
+ * wait until a worker takes a task, whereas try_submit refuses the task.
+ * Note that a task must not wait for a full queue of its own pool.
+ *
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;               //!< worker threads
+    std::deque<std::function<void()> > tasks;       //!< pending tasks
+    std::mutex mtx;                                 //!< guards the task queue
+    std::condition_variable cv_task;                //!< signals arrival of a task
+    std::condition_variable cv_space;               //!< signals removal of a task from the queue
+    size_t max_queue;                               //!< maximum number of pending tasks (0: unbounded)
+    bool stopping;                                  //!< set when the pool is destroyed
+
+public:
+    /*
+     * @fn WorkerPool
+     *
+     * @brief WorkerPool constructor
+     *
+     * @param nr_threads number of worker threads (0 uses the hardware concurrency)
+     * @param max_queue  maximum number of pending tasks (0: unbounded)
+     *
+     */
+    WorkerPool(unsigned int nr_threads = 0, size_t max_queue = 0);
+
+    /*
+     * @fn ~WorkerPool
+     *
+     * @brief finish all pending tasks and join the worker threads
+     *
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /*
+     * @fn submit
+     *
+     * @brief schedule a task on the pool, waiting while the queue is full
+     *
+     * @param f callable without arguments
+     *
+     * @return future holding the result (or exception) of the task
+     */
+    template<typename F>
+    auto submit(F&& f) -> std::future<decltype(f())> {
+        typedef decltype(f()) R;
+        auto task = std::make_shared<std::packaged_task<R()> >(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        this->enqueue([task]() { (*task)(); }, true);
+        return result;
+    }
+
+    /*
+     * @fn try_submit
+     *
+     * @brief schedule a task on the pool unless the queue is full
+     *
+     * @param f callable without arguments
+     *
+     * @return future holding the result of the task (empty if the task was refused)
+     */
+    template<typename F>
+    auto try_submit(F&& f) -> std::optional<std::future<decltype(f())> > {
+        typedef decltype(f()) R;
+        auto task = std::make_shared<std::packaged_task<R()> >(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        if(!this->enqueue([task]() { (*task)(); }, false)) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    /*
+     * @fn get_nr_threads
+     *
+     * @brief get the number of worker threads
+     *
+     * @return number of threads
+     */
+    inline unsigned int get_nr_threads() const {
+        return this->threads.size();
+    }
+
+    /*
+     * @fn get_nr_pending
+     *
+     * @brief get the number of tasks waiting for a worker
+     *
+     * @return number of tasks
+     */
+    size_t get_nr_pending();
+
+private:
+    /*
+     * @fn enqueue
+     *
+     * @brief place a task in the queue and wake up a worker
+     *
+     * @param task task to execute
+     * @param wait whether to wait for room in a full queue
+     *
+     * @return whether the task was queued
+     */
+    bool enqueue(std::function<void()>&& task, bool wait);
+
+    /*
+     * @fn run
+     *
+     * @brief main loop of a worker thread
+     *
+     */
+    void run();
+};
+
+} // Svg2Cairo::
+
+#endif //_WORKER_POOL
@@ -0,0 +1,335 @@
+/************************************************************************************
+ *   xml_stream.cpp  --  This file is part of LIBYASVG.                             *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "xml_stream.h"
+
+#include <boost/property_tree/xml_parser.hpp>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // size of the blocks read from the stream
+    const size_t XML_BLOCK_SIZE = 1 << 16;
+
+    inline bool is_whitespace(int c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /*
+     * @fn is_xml_char
+     *
+     * @brief whether a code point may occur in an XML document
+     *
+     */
+    inline bool is_xml_char(unsigned long code) {
+        return code == 0x9 || code == 0xA || code == 0xD ||
+               (code >= 0x20 && code <= 0xD7FF) ||
+               (code >= 0xE000 && code <= 0xFFFD) ||
+               (code >= 0x10000 && code <= 0x10FFFF);
+    }
+
+    /*
+     * @fn append_utf8
+     *
+     * @brief append a code point to a string in UTF-8 encoding
+     *
+     */
+    void append_utf8(std::string& str, unsigned long code) {
+        if(code < 0x80) {
+            str += (char)code;
+        } else if(code < 0x800) {
+            str += (char)(0xC0 | (code >> 6));
+            str += (char)(0x80 | (code & 0x3F));
+        } else if(code < 0x10000) {
+            str += (char)(0xE0 | (code >> 12));
+            str += (char)(0x80 | ((code >> 6) & 0x3F));
+            str += (char)(0x80 | (code & 0x3F));
+        } else {
+            str += (char)(0xF0 | (code >> 18));
+            str += (char)(0x80 | ((code >> 12) & 0x3F));
+            str += (char)(0x80 | ((code >> 6) & 0x3F));
+            str += (char)(0x80 | (code & 0x3F));
+        }
+    }
+}
+
+/*****************************************************************
+ * XML STREAM READER
+ *****************************************************************/
+
+Svg2Cairo::XmlStreamReader::XmlStreamReader(std::istream& _in) :
+    in(_in), buffer(XML_BLOCK_SIZE), pos(0), len(0), line(1), pending_end(false) {}
+
+Svg2Cairo::XmlStreamReader::Event Svg2Cairo::XmlStreamReader::next() {
+    if(this->pending_end) {
+        this->pending_end = false;
+        this->open.pop_back();
+        return XML_END;
+    }
+
+    while(true) {
+        // text between the tags is not used
+        int c = this->get();
+        while(c != '<' && c != EOF) {
+            c = this->get();
+        }
+        if(c == EOF) {
+            if(!this->open.empty()) {
+                this->fail("unexpected end of data, expected </" + this->open.back() + ">");
+            }
+            return XML_EOF;
+        }
+
+        c = this->peek();
+        if(c == '?') {
+            this->skip_until("?>");
+        } else if(c == '!') {
+            this->get();
+            this->skip_declaration();
+        } else if(c == '/') {
+            this->get();
+            this->read_end();
+            return XML_END;
+        } else {
+            this->read_start();
+            return XML_START;
+        }
+    }
+}
+
+void Svg2Cairo::XmlStreamReader::skip_element() {
+    const size_t depth = this->open.size();
+    while(this->open.size() >= depth) {
+        if(this->next() == XML_EOF) {
+            return;
+        }
+    }
+}
+
+void Svg2Cairo::XmlStreamReader::read_element(boost::property_tree::ptree& tree) {
+    const size_t depth = this->open.size();
+    std::vector<boost::property_tree::ptree*> parents = {&tree};
+    while(true) {
+        const Event event = this->next();
+        if(event == XML_EOF) {
+            return;
+        }
+        if(this->open.size() < depth) {
+            return;     // end of the element itself
+        }
+        if(event == XML_START) {
+            auto it = parents.back()->push_back(std::make_pair(this->name, this->node));
+            parents.push_back(&it->second);
+        } else {
+            parents.pop_back();
+        }
+    }
+}
+
+bool Svg2Cairo::XmlStreamReader::fill() {
+    this->in.read(this->buffer.data(), this->buffer.size());
+    this->len = this->in.gcount();
+    this->pos = 0;
+    return this->len != 0;
+}
+
+void Svg2Cairo::XmlStreamReader::fail(const std::string& message) const {
+    throw boost::property_tree::xml_parser_error(message, "", this->line);
+}
+
+void Svg2Cairo::XmlStreamReader::skip_until(const char* terminator) {
+    // compare the most recent characters with the terminator
+    const size_t n = std::strlen(terminator);
+    std::string recent;
+    while(recent.size() < n || recent.compare(recent.size() - n, n, terminator) != 0) {
+        const int c = this->get();
+        if(c == EOF) {
+            this->fail(std::string("unexpected end of data, expected ") + terminator);
+        }
+        if(recent.size() == n) {
+            recent.erase(0, 1);
+        }
+        recent += (char)c;
+    }
+}
+
+void Svg2Cairo::XmlStreamReader::skip_declaration() {
+    if(this->peek() == '-') {
+        this->get();
+        if(this->get() != '-') {
+            this->fail("invalid comment");
+        }
+        this->skip_until("-->");
+        return;
+    }
+
+    if(this->peek() == '[') {
+        this->skip_until("]]>");
+        return;
+    }
+
+    // <!DOCTYPE ...>, possibly with an internal subset in brackets
+    int depth = 0;
+    while(true) {
+        const int c = this->get();
+        if(c == EOF) {
+            this->fail("unexpected end of data in declaration");
+        }
+        if(c == '[') {
+            depth++;
+        } else if(c == ']') {
+            depth--;
+        } else if(c == '>' && depth <= 0) {
+            return;
+        }
+    }
+}
+
+std::string Svg2Cairo::XmlStreamReader::read_name() {
+    std::string result;
+    int c = this->peek();
+    while(c != EOF && !is_whitespace(c) && c != '=' && c != '/' && c != '>') {
+        result += (char)this->get();
+        c = this->peek();
+    }
+    if(result.empty()) {
+        this->fail("expected name");
+    }
+    return result;
+}
+
+void Svg2Cairo::XmlStreamReader::skip_whitespace() {
+    while(is_whitespace(this->peek())) {
+        this->get();
+    }
+}
+
+void Svg2Cairo::XmlStreamReader::read_start() {
+    this->name = this->read_name();
+    this->node.clear();
+    this->open.push_back(this->name);
+
+    boost::property_tree::ptree* attributes = nullptr;
+    while(true) {
+        this->skip_whitespace();
+        const int c = this->peek();
+        if(c == '>') {
+            this->get();
+            return;
+        }
+        if(c == '/') {
+            this->get();
+            if(this->get() != '>') {
+                this->fail("expected >");
+            }
+            this->pending_end = true;
+            return;
+        }
+        if(c == EOF) {
+            this->fail("unexpected end of data in element <" + this->name + ">");
+        }
+
+        const std::string key = this->read_name();
+        this->skip_whitespace();
+        if(this->get() != '=') {
+            this->fail("expected =");
+        }
+        this->skip_whitespace();
+        const int quote = this->get();
+        if(quote != '"' && quote != '\'') {
+            this->fail("expected ' or \"");
+        }
+        std::string value;
+        for(int v = this->get(); v != quote; v = this->get()) {
+            if(v == EOF) {
+                this->fail("unexpected end of data in attribute value");
+            }
+            value += (char)v;
+        }
+
+        if(attributes == nullptr) {
+            attributes = &this->node.push_back(std::make_pair("<xmlattr>", boost::property_tree::ptree()))->second;
+        }
+        attributes->push_back(std::make_pair(key, boost::property_tree::ptree(decode(value))));
+    }
+}
+
+void Svg2Cairo::XmlStreamReader::read_end() {
+    const std::string end_name = this->read_name();
+    this->skip_whitespace();
+    if(this->get() != '>') {
+        this->fail("expected >");
+    }
+    if(this->open.empty() || this->open.back() != end_name) {
+        this->fail("invalid closing tag </" + end_name + ">");
+    }
+    this->open.pop_back();
+    this->name = end_name;
+}
+
+std::string Svg2Cairo::XmlStreamReader::decode(const std::string& value) const {
+    if(value.find('&') == std::string::npos) {
+        return value;
+    }
+
+    std::string result;
+    size_t i = 0;
+    while(i < value.size()) {
+        const size_t semicolon = value[i] == '&' ? value.find(';', i) : std::string::npos;
+        if(semicolon == std::string::npos) {
+            result += value[i++];
+            continue;
+        }
+
+        const std::string entity = value.substr(i + 1, semicolon - i - 1);
+        if(entity == "lt") {
+            result += '<';
+        } else if(entity == "gt") {
+            result += '>';
+        } else if(entity == "amp") {
+            result += '&';
+        } else if(entity == "quot") {
+            result += '"';
+        } else if(entity == "apos") {
+            result += '\'';
+        } else if(entity.size() > 1 && entity[0] == '#') {
+            const bool hex = entity[1] == 'x';
+            const char* digits = entity.c_str() + (hex ? 2 : 1);
+            char* stop = nullptr;
+            const unsigned long code = std::isxdigit((unsigned char)*digits) ? std::strtoul(digits, &stop, hex ? 16 : 10) : 0;
+            if(stop != entity.c_str() + entity.size() || !is_xml_char(code)) {
+                this->fail("invalid character reference &" + entity + ";");
+            }
+            append_utf8(result, code);
+        } else {
+            // unknown entities are kept as they are
+            result += value.substr(i, semicolon - i + 1);
+        }
+        i = semicolon + 1;
+    }
+    return result;
+}
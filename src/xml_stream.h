@@ -0,0 +1,261 @@
+/************************************************************************************
+ *   xml_stream.h  --  This file is part of LIBYASVG.                               *
+ *                                                                                  *
+ *   MIT License                                                                    *
+ *                                                                                  *
+ *   Copyright (c) 2017 Ivo Filot <ivo@ivofilot.nl>                                 *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy   *
+ *   of this software and associated documentation files (the "Software"), to deal  *
+ *   in the Software without restriction, including without limitation the rights   *
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ *   copies of the Software, and to permit persons to whom the Software is          *
+ *   furnished to do so, subject to the following conditions:                       *
+ *                                                                                  *
+ *   The above copyright notice and this permission notice shall be included in all *
+ *   copies or substantial portions of the Software.                                *
+ *                                                                                  *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ *   SOFTWARE.                                                                      *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef _XML_STREAM
+#define _XML_STREAM
+
+#include <boost/property_tree/ptree.hpp>
+#include <cstdio>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Svg2Cairo {
+
+/*****************************************************************
+ * XML STREAM READER
+ *****************************************************************/
+
+/*
+ * @class XmlStreamReader
+ *
+ * @brief incremental XML reader producing one element at a time
+ *
+ * Only the structure of the document (elements and their attributes) is
+ * reported; text, comments, processing instructions, CDATA sections and
+ * the document type declaration are skipped. The attributes of the
+ * current element are presented as a property tree node in the layout
+ * produced by boost::property_tree::read_xml, i.e. as children of the
+ * "<xmlattr>" node, such that the same conversion code applies to both.
+ *
+ * The input is read in blocks; memory use is independent of the size
+ * of the document. Malformed input raises xml_parser_error.
+ *
+ */
+class XmlStreamReader {
+public:
+    enum Event {
+        XML_START,      //!< start of an element (an empty element is followed by its XML_END)
+        XML_END,        //!< end of an element
+        XML_EOF         //!< end of the document
+    };
+
+private:
+    std::istream& in;                   //!< source of the document
+    std::vector<char> buffer;           //!< block of input
+    size_t pos;                         //!< position of the next character in the buffer
+    size_t len;                         //!< number of valid characters in the buffer
+    unsigned long line;                 //!< current line (for error messages)
+
+    std::vector<std::string> open;      //!< names of the elements that are not yet closed
+    std::string name;                   //!< name of the current element
+    boost::property_tree::ptree node;   //!< attributes of the current element
+    bool pending_end;                   //!< the current element was empty; its end is reported next
+
+public:
+    /*
+     * @fn XmlStreamReader
+     *
+     * @brief XmlStreamReader constructor
+     *
+     * @param in    stream holding the document
+     *
+     */
+    XmlStreamReader(std::istream& in);
+
+    /*
+     * @fn next
+     *
+     * @brief advance to the next start or end of an element
+     *
+     * @return kind of event
+     */
+    Event next();
+
+    /*
+     * @fn skip_element
+     *
+     * @brief skip the children of the current element, up to and including its end
+     *
+     */
+    void skip_element();
+
+    /*
+     * @fn read_element
+     *
+     * @brief read the children of the current element into a property tree
+     *
+     * Reads up to and including the end of the current element, which
+     * afterwards is the current element again.
+     *
+     * @param tree  node receiving the child elements (in the layout of read_xml)
+     *
+     */
+    void read_element(boost::property_tree::ptree& tree);
+
+    /*
+     * @fn get_name
+     *
+     * @brief get the name of the current element
+     *
+     */
+    inline const std::string& get_name() const {
+        return this->name;
+    }
+
+    /*
+     * @fn get_node
+     *
+     * @brief get the attributes of the current element (valid until next is called)
+     *
+     */
+    inline const boost::property_tree::ptree& get_node() const {
+        return this->node;
+    }
+
+    /*
+     * @fn get_depth
+     *
+     * @brief get the number of open elements (including the current one after XML_START)
+     *
+     */
+    inline size_t get_depth() const {
+        return this->open.size();
+    }
+
+private:
+    /*
+     * @fn get
+     *
+     * @brief consume the next character
+     *
+     * @return character (EOF at the end of the input)
+     */
+    inline int get() {
+        if(this->pos == this->len && !this->fill()) {
+            return EOF;
+        }
+        const char c = this->buffer[this->pos++];
+        if(c == '\n') {
+            this->line++;
+        }
+        return (unsigned char)c;
+    }
+
+    /*
+     * @fn peek
+     *
+     * @brief look at the next character without consuming it
+     *
+     * @return character (EOF at the end of the input)
+     */
+    inline int peek() {
+        if(this->pos == this->len && !this->fill()) {
+            return EOF;
+        }
+        return (unsigned char)this->buffer[this->pos];
+    }
+
+    /*
+     * @fn fill
+     *
+     * @brief read the next block of input
+     *
+     * @return whether any characters were read
+     */
+    bool fill();
+
+    /*
+     * @fn fail
+     *
+     * @brief raise an xml_parser_error at the current line
+     *
+     */
+    [[noreturn]] void fail(const std::string& message) const;
+
+    /*
+     * @fn skip_until
+     *
+     * @brief consume characters up to and including a terminating sequence
+     *
+     */
+    void skip_until(const char* terminator);
+
+    /*
+     * @fn skip_declaration
+     *
+     * @brief consume a <!...> construct (comment, CDATA section or declaration)
+     *
+     */
+    void skip_declaration();
+
+    /*
+     * @fn read_name
+     *
+     * @brief read an element or attribute name
+     *
+     */
+    std::string read_name();
+
+    /*
+     * @fn skip_whitespace
+     *
+     * @brief consume whitespace characters
+     *
+     */
+    void skip_whitespace();
+
+    /*
+     * @fn read_start
+     *
+     * @brief read the name and attributes of a start tag (after the '<')
+     *
+     */
+    void read_start();
+
+    /*
+     * @fn read_end
+     *
+     * @brief read an end tag (after the "</")
+     *
+     */
+    void read_end();
+
+    /*
+     * @fn decode
+     *
+     * @brief replace character and entity references in an attribute value
+     *
+     * Character references that are not a number or do not denote a valid
+     * XML character raise an error.
+     *
+     */
+    std::string decode(const std::string& value) const;
+};
+
+} // Svg2Cairo::
+
+#endif //_XML_STREAM